@@ -1,21 +1,41 @@
 #include "bskytree/node.h"
 
-void ClearSkyTree(Node& skytree) {
-	std::stack<Node> tree_stack;
-	PushStack(tree_stack, skytree);
+TupleIdx FlatSkyTree::NumNodes(const TupleIdx first,
+		const TupleIdx last) const {
+	TupleIdx count = last - first;
+	for (TupleIdx c = first; c < last; c++)
+		count += NumNodes(first_child[c], first_child[c] + num_children[c]);
+	return count;
+}
+
+/* Copies a complete subtree (rooted at its node 0) into the slot of node
+ * slot, and its other nodes after all nodes so far. */
+void FlatSkyTree::Append(const FlatSkyTree &subtree, const TupleIdx slot) {
+	const TupleIdx offset = size() - 1; // node i > 0 goes to offset + i
+	SetNode(slot, subtree.lattice[0], subtree.point[0]);
+	first_child[slot] = subtree.first_child[0] + offset;
+	num_children[slot] = subtree.num_children[0];
 
-	while (!tree_stack.empty()) {
-		tree_stack.top().children.clear();
-		tree_stack.pop();
-	}
+	lattice.insert(lattice.end(), subtree.lattice.begin() + 1,
+			subtree.lattice.end());
+	point.insert(point.end(), subtree.point.begin() + 1, subtree.point.end());
+	num_children.insert(num_children.end(), subtree.num_children.begin() + 1,
+			subtree.num_children.end());
+	first_child.reserve(offset + subtree.size());
+	for (TupleIdx i = 1; i < subtree.size(); i++)
+		first_child.push_back(subtree.first_child[i] + offset);
 }
 
-void PushStack(std::stack<Node>& tree_stack, Node& skytree) {
-	if (skytree.children.size() > 0) {
-		tree_stack.push(skytree);
+void FlatSkyTree::Reserve(const TupleIdx capacity) {
+	lattice.reserve(capacity);
+	first_child.reserve(capacity);
+	num_children.reserve(capacity);
+	point.reserve(capacity);
+}
 
-		const uint32_t num_child = skytree.children.size();
-		for (unsigned i = 0; i < num_child; i++)
-			PushStack(tree_stack, skytree.children[i]);
-	}
+void FlatSkyTree::Clear() {
+	lattice.clear();
+	first_child.clear();
+	num_children.clear();
+	point.clear();
 }
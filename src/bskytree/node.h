@@ -3,21 +3,53 @@
 #include <stdint.h>
 
 #include <vector>
-#include <stack>
 
 #include "common/common.h"
 
-struct Node {
-	uint32_t lattice;
-	TUPLE point;
-	std::vector<Node> children;
+/*
+ * A SkyTree stored in contiguous arrays (an arena), rather than as nodes
+ * that own vectors of child nodes. The children of node i are the nodes
+ * [first_child[i], first_child[i] + num_children[i]), in ascending order
+ * of lattice, so that sibling lattices are scanned sequentially. Lattices
+ * are kept in their own dense array, since traversals read the lattice of
+ * every child but the point of only a few.
+ *
+ * A node reserves a slot for each of its potential children before any
+ * is built (see AddNodes()); the slots its children do not fill stay
+ * unused.
+ */
+struct FlatSkyTree {
+	std::vector<uint32_t> lattice;
+	std::vector<TupleIdx> first_child;
+	std::vector<uint32_t> num_children;
+	std::vector<TUPLE> point;
 
-	Node(void) {
-		lattice = 0;
+	inline TupleIdx size() const {
+		return lattice.size();
 	}
-	Node(uint32_t _lattice): lattice(_lattice) {
+
+	/* Appends count (empty, childless) node slots and returns the index
+	 * of the first. */
+	inline TupleIdx AddNodes(const TupleIdx count) {
+		const TupleIdx idx = size();
+		lattice.resize(idx + count);
+		first_child.resize(idx + count, 0);
+		num_children.resize(idx + count, 0);
+		point.resize(idx + count);
+		return idx;
 	}
-};
 
-void ClearSkyTree(Node& skytree);
-void PushStack(std::stack<Node>& tree_stack, Node& skytree);
+	/* Fills the slot of node idx. */
+	inline void SetNode(const TupleIdx idx, const uint32_t _lattice,
+			const TUPLE &_point) {
+		lattice[idx] = _lattice;
+		point[idx] = _point;
+	}
+
+	/* Number of nodes in the subtrees of the siblings [first, last). */
+	TupleIdx NumNodes(const TupleIdx first, const TupleIdx last) const;
+
+	void Append(const FlatSkyTree &subtree, const TupleIdx slot);
+	void Reserve(const TupleIdx capacity);
+	void Clear();
+};
@@ -16,37 +16,64 @@
 
 #include <common/skyline_i.h>
 #include <bskytree/node.h>
+#include <common/atomic_bitset.h>
+#include <common/compaction.h>
+#include <common/shared_dataset.h>
+#include <common/work_stealing.h>
 
 using namespace std;
 
 class ParallelBSkyTree: public SkylineI {
 public:
-  ParallelBSkyTree( const uint32_t num_threads, const uint32_t n,
-      const uint32_t d, float** dataset );
+  ParallelBSkyTree( const uint32_t num_threads, const TupleIdx n,
+      const uint32_t d, float** dataset,
+      const uint32_t pivot_type = PIVOT_BALSKY );
   virtual ~ParallelBSkyTree();
 
   void Init( float** dataset );
-  vector<int> Execute( void );
+  void InitShared( const SharedDataset &data );
+  vector<TupleId> Execute( void );
 
 private:
+  void InitBuffers();
   void BSkyTreeS_ALGO();
   void DoPartioning();
+  void PartitionShared();
+  void SplitLargePartitions();
+  void SortByPartition();
+  void SplitPartition( const TupleIdx begin, const TupleIdx end );
+  void ProcessHead( const TupleIdx th, const TupleIdx htail,
+      const TupleIdx tail );
+  TupleIdx ProcessHeadsSequential( const TupleIdx head, TupleIdx htail );
+  TupleIdx RemoveDeadSequential( const TupleIdx head, const TupleIdx tail );
+
+  /* Compares the temporal head th against all active tuples after the heads. */
+  struct HeadTask {
+    ParallelBSkyTree* const owner;
+    const TupleIdx htail, tail;
+    inline void operator()( const TupleIdx th ) const {
+      owner->ProcessHead( th, htail, tail );
+    }
+  };
 
   // PivotSelection methods
   void SelectBalanced();
-  vector<float> SetRangeList( const vector<float>& min_list,
-      const vector<float>& max_list );
-  float ComputeDistance( const float* value, const vector<float>& min_list,
-      const vector<float>& range_list );
-  bool EvaluatePoint( const uint32_t pos );
 
   const uint32_t num_threads_;
-  const uint32_t n_;
+  const TupleIdx n_;
   const uint32_t d_;
-  vector<TUPLE_S> data_;
+  const uint32_t pivot_type_; // PIVOT_*, see pivot_policy.h
+  const TUPLE* shared_; // the shared tuples, if not yet copied to data_
+  TUPLE_S* data_;
+  TupleIdx size_; // number of tuples in data_
 
-  vector<int> skyline_;
-  vector<int> eqm_; // "equivalence matrix"
+  vector<TupleId> skyline_;
+  vector<TupleId> eqm_; // "equivalence matrix"
+  uint64_t* dead_words_; // storage of dead_
+  AtomicBitset dead_; // tuples of data_ found to be dominated
+  ParallelCompactor<TUPLE_S> compactor_;
+  TUPLE_S* staging_; // buffer of compactor_
+  WorkStealingScheduler scheduler_;
 };
 
 #endif /* PARALLEL_BSKYTREE_H_ */
@@ -3,29 +3,333 @@
 #include <limits.h>
 #include <math.h>
 
+#include <cassert>
 #include <vector>
+#include <algorithm>
 
 #include "common/common.h"
+#include "common/pivot_policy.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#define omp_get_num_threads() 1
+#endif
 
 using namespace std;
 
 class PivotSelection {
 public:
-	PivotSelection( const vector<float> &min_list, const vector<float> &max_list);
+	PivotSelection( const vector<float> &min_list, const vector<float> &max_list,
+			const uint32_t policy = PIVOT_BALSKY );
 	~PivotSelection(void);
 
-	void Execute( vector<TUPLE>& dataset );
+	template<typename T>
+	TupleIdx Execute( T* dataset, const TupleIdx size,
+			const uint32_t num_threads = 1 );
+
+	template<typename T>
+	TupleIdx Find( const T* dataset, const TupleIdx size,
+			const uint32_t num_threads = 1 );
 
 private:
+	template<typename T>
+	TupleIdx SelectInRange( T* dataset, const TupleIdx size,
+			const vector<float>& range_list, const bool seek_min,
+			TupleIdx random_state );
 
 	vector<float> SetRangeList(const vector<float>& min_list,
 			const vector<float>& max_list);
-	float ComputeDistance(const float* value, const vector<float>& min_list,
-			const vector<float>& range_list);
-
-	bool EvaluatePoint(const unsigned pos, vector<TUPLE>& dataset);
+	inline float Cost(const float* value, const vector<float>& range_list) {
+		return PivotCost( policy_, value, &min_list_[0], &range_list[0] );
+	}
 
 	const vector<float> &min_list_;
 	const vector<float> &max_list_;
+	const uint32_t policy_; // PIVOT_*, see pivot_policy.h
 };
 
+
+// Templated member function has to be defined in a header file..
+
+/*
+ * Chooses a pivot of minimum cost under the policy (by default, minimum
+ * range; see PivotCost()). The chosen pivot is always a skyline point.
+ * In addition to that, removes points from dataset that are dominated
+ * by the pivot point.
+ *
+ * With several threads, each one selects a candidate in its own chunk
+ * of dataset (see SelectInRange()). The candidate of minimum cost that
+ * no other candidate dominates is then compared to all points in 
+ * parallel, removing those it dominates. Should some point dominate it,
+ * the dominator of least Manhattan norm becomes the pivot (and is 
+ * compared to all points once more); nothing can dominate that point,
+ * since it would dominate the candidate with a smaller norm.
+ *
+ * Uses up to num_threads threads if there are at least 
+ * PIVOT_PARALLEL_MIN points (and one otherwise).
+ *
+ * @param dataset The points, of which the pivot is moved to dataset[0].
+ * @param size The number of points in dataset (at least one).
+ * @return The number of points left at the front of dataset.
+ */
+template<typename T>
+TupleIdx PivotSelection::Execute(T* dataset, const TupleIdx size,
+    const uint32_t num_threads) {
+  const vector<float> range_list = SetRangeList( min_list_, max_list_ );
+  if ( num_threads <= 1 || size < PIVOT_PARALLEL_MIN )
+    return SelectInRange( dataset, size, range_list, false, RANDOM_SEED );
+
+  vector<TupleIdx> best( num_threads, size ), kept( num_threads, 0 );
+  vector<float> best_value( num_threads, 0 );
+  TupleIdx pivot = 0, moved = 0;
+  uint32_t team = 1;
+  bool found = true;
+  T candidate; // copied, since the threads move the points of their chunks
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    const uint32_t nt = omp_get_num_threads();
+    const uint32_t th = omp_get_thread_num();
+    const TupleIdx lo = (uint64_t) size * th / nt;
+    kept[th] = SelectInRange( dataset + lo,
+        (uint64_t) size * (th + 1) / nt - lo, range_list, true,
+        RANDOM_SEED + th );
+#pragma omp barrier
+#pragma omp single
+    {
+      /* Reduce: the candidate of least cost among those that are not
+       * dominated by another one. */
+      team = nt;
+      uint32_t c = nt;
+      float min_cost = 0;
+      for (uint32_t t = 0; t < nt; ++t) {
+        const TUPLE &cur = dataset[(uint64_t) size * t / nt];
+        bool dominated = false;
+        for (uint32_t u = 0; u < nt && !dominated; ++u)
+          dominated = DominateLeft( dataset[(uint64_t) size * u / nt], cur );
+        const float cost = Cost( cur.elems, range_list );
+        if ( !dominated && (c == nt || cost < min_cost) )
+          c = t, min_cost = cost;
+      }
+      pivot = (uint64_t) size * c / nt;
+      candidate = dataset[pivot];
+    } // END SINGLE
+
+    /* Verify: remove what the candidate dominates, and look for 
+     * dominators (at most twice; see above). */
+    while ( found ) {
+      const TupleIdx end = lo + kept[th];
+      TupleIdx w = lo, b = size;
+      float bv = 0;
+      for (TupleIdx i = lo; i < end; ++i) {
+        const int dtest = DominanceTest( candidate, dataset[i] );
+        if ( dtest == DOM_LEFT )
+          continue; // removed
+        if ( dtest == DOM_RIGHT ) {
+          float norm = 0;
+          for (uint32_t d = 0; d < NUM_DIMS; d++)
+            norm += dataset[i].elems[d];
+          if ( b == size || norm < bv )
+            b = w, bv = norm;
+        }
+        if ( i == pivot )
+          moved = w; // the candidate itself is never removed
+        dataset[w++] = dataset[i];
+      }
+      kept[th] = w - lo, best[th] = b, best_value[th] = bv;
+#pragma omp barrier
+#pragma omp single
+      {
+        uint32_t c = nt;
+        for (uint32_t t = 0; t < nt; ++t)
+          if ( best[t] < size && (c == nt || best_value[t] < best_value[c]) )
+            c = t;
+        found = c < nt;
+        pivot = found ? best[c] : moved;
+        candidate = dataset[pivot];
+      } // END SINGLE
+    }
+  } // END PARALLEL
+
+  // Close the gaps between the chunks, and move the pivot to the front.
+  TupleIdx out = 0;
+  for (uint32_t t = 0; t < team; ++t) {
+    const TupleIdx lo = (uint64_t) size * t / team;
+    if ( pivot >= lo && pivot < lo + kept[t] )
+      pivot = pivot - lo + out;
+    std::copy( dataset + lo, dataset + lo + kept[t], dataset + out );
+    out += kept[t];
+  }
+  std::swap( dataset[0], dataset[pivot] );
+  return out;
+}
+
+/*
+ * Chooses a pivot as Execute() does, but without moving (or removing)
+ * any point, so that dataset can be read-only. Each thread scans its
+ * chunk as SelectInRange() does, replacing its candidate by any point
+ * that dominates it or, if incomparable, has a smaller cost (so that
+ * costs are only computed for points that the candidate does not 
+ * dominate). The candidate of least cost that no other one dominates
+ * is then replaced by its dominator of least Manhattan norm, if any, in
+ * a second parallel pass. Under PIVOT_RANDOM, the first candidate is a
+ * random point instead.
+ *
+ * @param size The number of points in dataset (at least one).
+ * @return The index of the pivot in dataset.
+ */
+template<typename T>
+TupleIdx PivotSelection::Find(const T* dataset, const TupleIdx size,
+    const uint32_t num_threads) {
+  const vector<float> range_list = SetRangeList( min_list_, max_list_ );
+  TupleIdx pivot = 0;
+  if ( policy_ == PIVOT_RANDOM ) {
+    TupleIdx x = RANDOM_SEED;
+    pivot = NextRandom( x ) % size;
+  } else {
+    vector<TupleIdx> candidates( num_threads, size );
+    uint32_t team = 1;
+#pragma omp parallel num_threads(num_threads)
+    {
+      const uint32_t nt = omp_get_num_threads();
+      const uint32_t th = omp_get_thread_num();
+      const TupleIdx lo = (uint64_t) size * th / nt;
+      const TupleIdx hi = (uint64_t) size * (th + 1) / nt;
+      TupleIdx c = lo;
+      float c_cost = lo < hi ? Cost( dataset[lo].elems, range_list ) : 0;
+      for (TupleIdx i = lo + 1; i < hi; ++i) {
+        const int dtest = DominanceTest( dataset[c], dataset[i] );
+        if ( dtest == DOM_LEFT )
+          continue;
+        const float cost = Cost( dataset[i].elems, range_list );
+        if ( dtest == DOM_RIGHT || cost < c_cost )
+          c = i, c_cost = cost;
+      }
+      if ( lo < hi )
+        candidates[th] = c;
+#pragma omp single
+      team = nt;
+    } // END PARALLEL
+
+    /* Reduce: the candidate of least cost that no other one dominates. */
+    float min_cost = 0;
+    pivot = size;
+    for (uint32_t t = 0; t < team; ++t) {
+      const TupleIdx c = candidates[t];
+      if ( c == size )
+        continue;
+      bool dominated = false;
+      for (uint32_t u = 0; u < team && !dominated; ++u)
+        dominated = candidates[u] < size
+            && DominateLeft( dataset[candidates[u]], dataset[c] );
+      const float cost = Cost( dataset[c].elems, range_list );
+      if ( !dominated && (pivot == size || cost < min_cost) )
+        pivot = c, min_cost = cost;
+    }
+  }
+
+  const T candidate = dataset[pivot];
+  TupleIdx best = size;
+  float best_norm = 0;
+#pragma omp parallel num_threads(num_threads)
+  {
+    TupleIdx my_best = size;
+    float my_norm = 0;
+#pragma omp for nowait
+    for (TupleIdx i = 0; i < size; ++i) {
+      if ( !DominateLeft( dataset[i], candidate ) )
+        continue;
+      float norm = 0;
+      for (uint32_t d = 0; d < NUM_DIMS; d++)
+        norm += dataset[i].elems[d];
+      if ( my_best == size || norm < my_norm )
+        my_best = i, my_norm = norm;
+    }
+#pragma omp critical
+    {
+      if ( my_best < size && (best == size || my_norm < best_norm
+          || (my_norm == best_norm && my_best < best)) )
+        best = my_best, best_norm = my_norm;
+    }
+  } // END PARALLEL
+  return best < size ? best : pivot;
+}
+
+/*
+ * The sequential selection on dataset[0...size - 1]: scans the points,
+ * replacing the pivot (dataset[0]) by any point that dominates it, or by
+ * a point of smaller cost that no point before it dominates; removes
+ * the points that the current pivot dominates along the way.
+ *
+ * If seek_min is set, a linear pre-pass starts the scan from the point
+ * of minimum cost, so that the checks of points of smaller cost (linear
+ * in their position each) are only needed after the pivot was replaced
+ * by a dominator. This pays off for the large chunks of a parallel
+ * selection, but not for the many small ranges of the recursion, whose
+ * lazy scan rarely finds a cheaper point.
+ *
+ * Under PIVOT_RANDOM, all costs are equal, so the scan instead starts
+ * from a random point (drawn with NextRandom() from random_state), and
+ * only replaces it by its dominators.
+ *
+ * @return The number of points left at the front of dataset.
+ */
+template<typename T>
+TupleIdx PivotSelection::SelectInRange(T* dataset, const TupleIdx size,
+    const vector<float>& range_list, const bool seek_min,
+    TupleIdx random_state) {
+  if ( size < 2 )
+    return size;
+
+  if ( policy_ == PIVOT_RANDOM )
+    std::swap( dataset[0], dataset[NextRandom( random_state ) % size] );
+
+  float min_cost = Cost( dataset[0].elems, range_list );
+  if ( seek_min && policy_ != PIVOT_RANDOM ) {
+    TupleIdx head = 0;
+    for (TupleIdx i = 1; i < size; ++i) {
+      const float cost = Cost( dataset[i].elems, range_list );
+      if ( cost < min_cost )
+        head = i, min_cost = cost;
+    }
+    std::swap( dataset[0], dataset[head] );
+  }
+
+  TupleIdx tail = size - 1, cur_pos = 1;
+  while ( cur_pos <= tail ) {
+    const uint32_t dtest = DominanceTest( dataset[0], dataset[cur_pos] );
+    if ( dtest == DOM_LEFT ) {
+      dataset[cur_pos] = dataset[tail];
+      tail--;
+    } else if ( dtest == DOM_RIGHT ) {
+      dataset[0] = dataset[cur_pos];
+      dataset[cur_pos] = dataset[tail];
+      tail--;
+
+      min_cost = Cost( dataset[0].elems, range_list );
+      cur_pos = 1;
+    } else {
+      assert( dtest == DOM_INCOMP );
+      const float cur_cost = Cost( dataset[cur_pos].elems, range_list );
+
+      if ( cur_cost < min_cost ) {
+        // Is the point dominated by any of the points before it?
+        TupleIdx i = 0;
+        while ( i < cur_pos && !DominatedLeft( dataset[cur_pos], dataset[i] ) )
+          ++i;
+        if ( i == cur_pos ) {
+          std::swap( dataset[0], dataset[cur_pos] );
+          min_cost = cur_cost;
+          cur_pos++;
+        } else {
+          dataset[cur_pos] = dataset[tail];
+          tail--;
+        }
+      } else
+        cur_pos++;
+    }
+  }
+  return tail + 1;
+}
@@ -1,40 +1,65 @@
 #include "bskytree/skytree.h"
 #include <cstdio>
 #include <cassert>
+#include <algorithm>
 
-uint32_t countSkyTree( Node& skytree ) {
-  uint32_t count = 0;
-  uint32_t num_child = skytree.children.size();
-  for (uint32_t c = 0; c < num_child; c++)
-    count += countSkyTree( skytree.children[c] );
-  return count + 1;
+#include "common/radix_sort.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+/* Orders (separately built) subtrees by the lattice of their roots, as 
+ * FilterPoint() and PartialDominance() expect of siblings when they stop
+ * at the first larger lattice. */
+static bool CompareLattice( const FlatSkyTree *a, const FlatSkyTree *b ) {
+  return a->lattice[0] < b->lattice[0];
 }
 
-SkyTree::SkyTree( const uint32_t n, const uint32_t d, float** dataset,
-    const bool useTree, const bool useDnC ) :
-    n_( n ), d_( d ), useTree_( useTree ), useDnC_( useDnC ) {
+SkyTree::SkyTree( const TupleIdx n, const uint32_t d, float** dataset,
+    const bool useTree, const bool useDnC, const uint32_t num_threads,
+    const uint32_t pivot_type ) :
+    n_( n ), d_( d ), num_threads_( num_threads ), pivot_type_( pivot_type ),
+    shared_( NULL ), data_( NULL ), size_( 0 ), scratch_( NULL ),
+    codes_( NULL ), order_( NULL ), useTree_( useTree ), useDnC_( useDnC ) {
 
-  skytree_.lattice = 0;
+  skytree_.Reserve( 1024 );
   skyline_.reserve( 1024 );
   eqm_.reserve( 1024 );
   dominated_ = NULL;
 }
 
 void SkyTree::Init( float** dataset ) {
-  data_.reserve( n_ );
-  for (uint32_t i = 0; i < n_; i++) {
-    TUPLE t;
-    t.pid = i;
+  data_ = AllocBuffer<TUPLE>( n_ );
+  size_ = n_;
+  for (TupleIdx i = 0; i < n_; i++) {
+    data_[i].pid = i;
     for (uint32_t j = 0; j < NUM_DIMS; j++) {
-      t.elems[j] = dataset[i][j];
+      data_[i].elems[j] = dataset[i][j];
     }
-    data_.push_back( t );
   }
+  InitBuffers();
+}
+
+/*
+ * Copies nothing yet: the root's pivot selection and mapping to regions
+ * read the shared tuples in place, and only the tuples that survive them
+ * are then copied, already grouped by region (see MapSharedToRegion()).
+ */
+void SkyTree::InitShared( const SharedDataset &data ) {
+  shared_ = data.tuples();
+  InitBuffers();
+}
+
+void SkyTree::InitBuffers() {
+  scratch_ = AllocBuffer<TUPLE>( n_ );
+  codes_ = AllocBuffer<uint32_t>( n_ );
+  order_ = AllocBuffer<pair<uint32_t, TupleIdx> >( n_ );
   if ( useDnC_ ) {
-    const uint32_t n = n_;
+    const TupleIdx n = n_;
     if ( n > 0 ) {
-      dominated_ = new bool[n];
-      for (uint32_t i = 0; i < n; ++i)
+      dominated_ = AllocBuffer<bool>( n );
+      for (TupleIdx i = 0; i < n; ++i)
         dominated_[i] = false;
     } else
       useDnC_ = false; //so we don't try to delete[] dominated_.
@@ -45,23 +70,58 @@ SkyTree::~SkyTree( void ) {
   min_list_.clear();
   max_list_.clear();
   skyline_.clear();
-  ClearSkyTree( skytree_ );
-  data_.clear();
+  skytree_.Clear();
+  FreeBuffer( data_ );
+  FreeBuffer( scratch_ );
+  FreeBuffer( codes_ );
+  FreeBuffer( order_ );
   if ( useDnC_ )
-    delete[] dominated_;
+    FreeBuffer( dominated_ );
 }
 
-vector<int> SkyTree::Execute( void ) {
+vector<TupleId> SkyTree::Execute( void ) {
   const vector<float> min_list( NUM_DIMS, 0.0 );
   const vector<float> max_list( NUM_DIMS, 1.0 );
 
-  ComputeSkyTree( min_list, max_list, data_, skytree_ );
-  TraverseSkyTree( skytree_ );
-//  printf( " %d\n", MaxDepth(skytree_, 0) );
+  const bool parallel = num_threads_ > 0 && !useDnC_;
+  const TupleIdx root = skytree_.AddNodes( 1 );
+  if ( shared_ != NULL ) {
+    // the root's pivot and regions come from the shared tuples
+    const vector<Region> regions = MapSharedToRegion();
+    skytree_.SetNode( root, 0, data_[0] );
+    if ( parallel ) {
+#pragma omp parallel num_threads(num_threads_)
+      {
+#pragma omp single
+        ComputeChildrenParallel( min_list, max_list, data_, regions,
+            skytree_, root );
+      } // END PARALLEL
+    } else {
+      ComputeChildren( min_list, max_list, data_, regions, skytree_,
+          root );
+    }
+  } else if ( parallel && size_ >= SKYTREE_TASK_CUTOFF ) {
+    // the root's pivot is selected by all threads, before the tasks start
+    PivotSelection selection( min_list, max_list, pivot_type_ );
+    const TupleIdx size = selection.Execute( data_, size_, num_threads_ );
+    skytree_.SetNode( root, 0, data_[0] );
+    const vector<Region> regions = MapPointToRegion( data_, size );
+#pragma omp parallel num_threads(num_threads_)
+    {
+#pragma omp single
+      ComputeChildrenParallel( min_list, max_list, data_, regions,
+          skytree_, root );
+    } // END PARALLEL
+  } else {
+    ComputeSkyTree( min_list, max_list, data_, size_, 0,
+        skytree_, root );
+  }
+  TraverseSkyTree( skytree_, 0 );
+//  printf( " %d\n", MaxDepth(skytree_, 0, 0) );
 
 #ifndef NVERBOSE
-//  const uint32_t skytree_size = countSkyTree( skytree_ );
-//  const int depth = MaxDepth( skytree_, 0 );
+//  const uint32_t skytree_size = skytree_.size();
+//  const int depth = MaxDepth( skytree_, 0, 0 );
 //  printf( " Skytree: total_children=%u, height=%d, skyline size=%lu\n",
 //      skytree_size, depth, skyline_.size() );
 //  uint32_t num_nodes = 0;
@@ -74,9 +134,9 @@ vector<int> SkyTree::Execute( void ) {
 //  assert( depth == skytree_levels_.size() );
 
   if ( useDnC_ ) {
-    const uint32_t skytree_size = countSkyTree( skytree_ );
-    printf( "Skytree size=%u, Skyline size=%lu\n", skytree_size,
-        skyline_.size() );
+    const TupleIdx skytree_size = skytree_.NumNodes( 0, 1 );
+    printf( "Skytree size=%llu, Skyline size=%lu\n",
+        (unsigned long long) skytree_size, skyline_.size() );
   }
 #endif
 
@@ -86,25 +146,41 @@ vector<int> SkyTree::Execute( void ) {
   return skyline_;
 }
 
-void SkyTree::ComputeSkyTree( const vector<float> min_list,
-    const vector<float> max_list, vector<TUPLE>& dataset, Node& skytree ) {
+void SkyTree::ComputeSkyTree( const vector<float> &min_list,
+    const vector<float> &max_list, TUPLE* dataset, TupleIdx size,
+    const uint32_t lattice, FlatSkyTree& tree, const TupleIdx node ) {
   // pivot selection in the dataset
-  PivotSelection selection( min_list, max_list );
-  selection.Execute( dataset );
+  PivotSelection selection( min_list, max_list, pivot_type_ );
+  size = selection.Execute( dataset, size );
 
   // mapping points to binary vectors representing subregions
-  skytree.point = dataset[0];
-  map<uint32_t, vector<TUPLE> > point_map = MapPointToRegion( dataset );
-
-  for (map<uint32_t, vector<TUPLE> >::const_iterator it = point_map.begin();
-      it != point_map.end(); it++) {
-    uint32_t cur_lattice = (*it).first;
-    vector<TUPLE> cur_dataset = (*it).second;
-
-    if ( !useDnC_ && skytree.children.size() > 0 )
-      PartialDominance( cur_lattice, cur_dataset, skytree ); // checking partial dominance relations
+  tree.SetNode( node, lattice, dataset[0] );
+  ComputeChildren( min_list, max_list, dataset,
+      MapPointToRegion( dataset, size ), tree, node );
+}
 
-    if ( cur_dataset.size() > 0 ) {
+/*
+ * Builds the children of node (whose pivot is dataset[0]) from the given
+ * regions of dataset.
+ */
+void SkyTree::ComputeChildren( const vector<float> &min_list,
+    const vector<float> &max_list, TUPLE* dataset,
+    const vector<Region> &regions, FlatSkyTree& tree, const TupleIdx node ) {
+  // one slot per region; the children are [first, first + num_children)
+  const TupleIdx first = tree.AddNodes( regions.size() );
+  tree.first_child[node] = first;
+
+  for (uint32_t r = 0; r < regions.size(); r++) {
+    const uint32_t cur_lattice = regions[r].lattice;
+    TUPLE* const cur_dataset = dataset + regions[r].begin;
+    TupleIdx cur_size = regions[r].size;
+
+    const TupleIdx last = first + tree.num_children[node];
+    if ( !useDnC_ && last > first )
+      cur_size = PartialDominance( cur_lattice, cur_dataset, cur_size, tree,
+          first, last ); // checking partial dominance relations
+
+    if ( cur_size > 0 ) {
       vector<float> min_list2( NUM_DIMS ), max_list2( NUM_DIMS );
       for (uint32_t d = 0; d < NUM_DIMS; d++) {
         const uint32_t bit = SHIFTS[d];
@@ -114,73 +190,288 @@ void SkyTree::ComputeSkyTree( const vector<float> min_list,
           min_list2[d] = min_list[d], max_list2[d] = dataset[0].elems[d];
       }
 
-      Node child_node( cur_lattice );
-      ComputeSkyTree( min_list2, max_list2, cur_dataset, child_node ); // recursive call
+      const TupleIdx child = last;
+      ++tree.num_children[node];
+      ComputeSkyTree( min_list2, max_list2, cur_dataset, cur_size,
+          cur_lattice, tree, child ); // recursive call
 
-      if ( useDnC_ && skytree.children.size() > 0 )
-        PartialDominance_with_trees( cur_lattice, skytree, child_node ); //pdom
-
-      skytree.children.push_back( child_node );
+      if ( useDnC_ && child > first )
+        PartialDominance_with_trees( cur_lattice, tree, first, child,
+            child ); //pdom
     }
   }
-
-//  delete point_map;
 }
 
-map<uint32_t, vector<TUPLE> > SkyTree::MapPointToRegion(
-    vector<TUPLE>& dataset ) {
-  const uint32_t pruned = SHIFTS[NUM_DIMS] - 1;
+/*
+ * Task-parallel variant of ComputeSkyTree(). A region can only be
+ * dominated by regions whose lattices are subsets of its own, and thus
+ * have fewer set bits. So the regions are processed level by level (by
+ * number of set bits): all regions of one level are filtered and
+ * recursed on as independent tasks (on disjoint ranges of dataset), and
+ * their subtrees are added to the children (sorted by lattice) before 
+ * the next level starts. Regions with fewer than SKYTREE_TASK_CUTOFF
+ * points run sequentially. (The root's pivot is instead selected by all
+ * threads in Execute(), outside of the tasks, with PivotSelection's 
+ * parallel selection.)
+ */
+void SkyTree::ComputeSkyTreeParallel( const vector<float> &min_list,
+    const vector<float> &max_list, TUPLE* dataset, TupleIdx size,
+    const uint32_t lattice, FlatSkyTree& tree, const TupleIdx node ) {
+  if ( size < SKYTREE_TASK_CUTOFF ) {
+    ComputeSkyTree( min_list, max_list, dataset, size, lattice, tree, node );
+    return;
+  }
 
-  map<uint32_t, vector<TUPLE> > data_map;
+  // pivot selection in the dataset
+  PivotSelection selection( min_list, max_list, pivot_type_ );
+  size = selection.Execute( dataset, size );
 
-  const TUPLE &pivot = dataset[0];
-  for (vector<TUPLE>::const_iterator it = dataset.begin() + 1;
-      it != dataset.end(); it++) {
+  // mapping points to binary vectors representing subregions
+  tree.SetNode( node, lattice, dataset[0] );
+  ComputeChildrenParallel( min_list, max_list, dataset,
+      MapPointToRegion( dataset, size ), tree, node );
+}
 
-    if ( EqualityTest( pivot, *it ) ) {
-      eqm_.push_back( it->pid );
+/*
+ * Task-parallel variant of ComputeChildren(), by levels of regions (see
+ * ComputeSkyTreeParallel()).
+ */
+void SkyTree::ComputeChildrenParallel( const vector<float> &min_list,
+    const vector<float> &max_list, TUPLE* dataset,
+    const vector<Region> &regions, FlatSkyTree& tree, const TupleIdx node ) {
+  const TUPLE pivot = dataset[0];
+  vector<vector<uint32_t> > levels( NUM_DIMS + 1 );
+  for (uint32_t r = 0; r < regions.size(); r++)
+    levels[__builtin_popcount( regions[r].lattice )].push_back( r );
+
+  /* Each task builds its subtree in a local arena; the completed
+   * subtrees are kept sorted by lattice and spliced in at the end. */
+  vector<FlatSkyTree*> subtrees;
+  for (uint32_t k = 0; k <= NUM_DIMS; ++k) {
+    const uint32_t num_regions = levels[k].size();
+    if ( num_regions == 0 )
       continue;
+
+    vector<FlatSkyTree*> level_trees( num_regions, (FlatSkyTree*) NULL );
+    for (uint32_t j = 0; j < num_regions; ++j) {
+      const Region region = regions[levels[k][j]];
+#pragma omp task default(shared) firstprivate(j, region)
+      {
+        const uint32_t cur_lattice = region.lattice;
+        TUPLE* const cur_dataset = dataset + region.begin;
+        TupleIdx cur_size = region.size;
+        if ( subtrees.size() > 0 )
+          cur_size = PartialDominanceParallel( cur_lattice, cur_dataset,
+              cur_size, subtrees ); // checking partial dominance relations
+
+        if ( cur_size > 0 ) {
+          vector<float> min_list2( NUM_DIMS ), max_list2( NUM_DIMS );
+          for (uint32_t d = 0; d < NUM_DIMS; d++) {
+            const uint32_t bit = SHIFTS[d];
+            if ( (cur_lattice & bit) == bit )
+              min_list2[d] = pivot.elems[d], max_list2[d] = max_list[d];
+            else
+              min_list2[d] = min_list[d], max_list2[d] = pivot.elems[d];
+          }
+
+          level_trees[j] = new FlatSkyTree();
+          const TupleIdx sub_root = level_trees[j]->AddNodes( 1 );
+          ComputeSkyTreeParallel( min_list2, max_list2, cur_dataset, cur_size,
+              cur_lattice, *level_trees[j], sub_root ); // recursive call
+        }
+      } // END TASK
     }
+#pragma omp taskwait
 
-    const uint32_t lattice = DT_bitmap_dvc( *it, pivot );
-    if ( lattice < pruned ) { // <-- Same fix as below (same if condition). Also doubles dt's.
-      assert( !DominateLeft( pivot, *it ) );
-      data_map[lattice].push_back( *it );
+    for (uint32_t j = 0; j < num_regions; ++j) {
+      if ( level_trees[j] != NULL )
+        subtrees.push_back( level_trees[j] );
     }
+    std::sort( subtrees.begin(), subtrees.end(), CompareLattice );
   }
 
-  return data_map;
+  const TupleIdx first = tree.AddNodes( subtrees.size() );
+  tree.first_child[node] = first;
+  tree.num_children[node] = subtrees.size();
+  for (uint32_t c = 0; c < subtrees.size(); ++c) {
+    tree.Append( *subtrees[c], first + c );
+    delete subtrees[c];
+  }
 }
 
-bool SkyTree::PartialDominance_with_trees( const uint32_t lattice,
-    Node& left_tree, Node& right_tree ) {
+/*
+ * Maps the points dataset[1...size - 1] to subregions by their lattice
+ * relative to the pivot dataset[0], and groups them by lattice in place.
+ * Points equal to the pivot are recorded in eqm_, and they and points 
+ * dominated by the pivot are moved behind the last region.
+ *
+ * The grouping is a counting sort that permutes the points in place by
+ * following cycles (i.e., an American flag sort), so each point is read 
+ * once to map it and moved at most once. If the lattice has many more
+ * cells than there are points, it sorts (code, index) pairs instead.
+ *
+ * @return The non-empty regions, in ascending order of lattice.
+ */
+vector<Region> SkyTree::MapPointToRegion( TUPLE* dataset,
+    const TupleIdx size ) {
+  const uint32_t pruned = SHIFTS[NUM_DIMS] - 1;
+  vector<Region> regions;
+  if ( size < 2 )
+    return regions;
 
-  uint32_t num_child = right_tree.children.size();
+  TUPLE* const points = dataset + 1;
+  const TupleIdx num = size - 1;
+  uint32_t* const codes = codes_ + (points - data_);
+  vector<TupleId> eqm; // collected locally, since regions may map concurrently
 
-  for (uint32_t c = 0; c < num_child; ++c) {
-    if ( PartialDominance_with_trees( lattice, left_tree,
-        right_tree.children[c] ) ) {
-      if ( right_tree.children[c].children.size() == 0 ) {
-        right_tree.children.erase( right_tree.children.begin() + c-- );
-        --num_child;
+  const TUPLE &pivot = dataset[0];
+  for (TupleIdx i = 0; i < num; i++) {
+    if ( EqualityTest( pivot, points[i] ) ) {
+      eqm.push_back( points[i].pid );
+      codes[i] = pruned;
+      continue;
+    }
+
+    codes[i] = DT_bitmap_dvc( points[i], pivot );
+    assert( codes[i] < pruned || DominateLeft( pivot, points[i] ) );
+  }
+  if ( !eqm.empty() ) {
+#pragma omp critical(skytree_eqm)
+    eqm_.insert( eqm_.end(), eqm.begin(), eqm.end() );
+  }
+
+  if ( (uint64_t) pruned + 1 <= 8 * (uint64_t) num ) {
+    /* Counting sort: bucket b occupies [start[b], start[b + 1]). */
+    vector<TupleIdx> start( pruned + 2, 0 );
+    for (TupleIdx i = 0; i < num; i++)
+      ++start[codes[i] + 1];
+    for (uint32_t b = 0; b <= pruned; b++)
+      start[b + 1] += start[b];
+
+    vector<TupleIdx> next( start.begin(), start.end() - 1 );
+    for (uint32_t b = 0; b < pruned; b++) {
+      while ( next[b] < start[b + 1] ) {
+        const TupleIdx i = next[b];
+        const uint32_t c = codes[i];
+        if ( c == b ) {
+          ++next[b];
+        } else {
+          const TupleIdx j = next[c]++;
+          std::swap( points[i], points[j] );
+          std::swap( codes[i], codes[j] );
+        }
+      }
+    }
+    for (uint32_t b = 0; b < pruned; b++) {
+      if ( start[b + 1] > start[b] ) {
+        const Region region = { b, start[b] + 1, start[b + 1] - start[b] };
+        regions.push_back( region );
       }
     }
+  } else {
+    /* Few points in a large lattice: sort (code, index) pairs instead. */
+    pair<uint32_t, TupleIdx>* const order = order_ + (points - data_);
+    for (TupleIdx i = 0; i < num; i++)
+      order[i] = pair<uint32_t, TupleIdx>( codes[i], i );
+    std::sort( order, order + num );
+
+    TUPLE* const sorted = scratch_ + (points - data_);
+    for (TupleIdx i = 0; i < num; i++)
+      sorted[i] = points[order[i].second];
+    std::copy( sorted, sorted + num, points );
+
+    for (TupleIdx i = 0; i < num && order[i].first < pruned;) {
+      Region region = { order[i].first, i + 1, 0 };
+      for (; i < num && order[i].first == region.lattice; i++)
+        ++region.size;
+      regions.push_back( region );
+    }
   }
 
-  num_child = left_tree.children.size();
-  for (uint32_t c = 0; c < num_child; c++) {
-    uint32_t cur_lattice = left_tree.children[c].lattice;
+  return regions;
+}
+
+/*
+ * MapPointToRegion() for the root, together with its pivot selection, on
+ * the shared tuples in place: finds the pivot without moving any tuple 
+ * (see PivotSelection::Find()), and then gathers it and the points of the
+ * regions into data_ once, grouped by a radix sort on their lattices.
+ *
+ * @return The non-empty regions, in ascending order of lattice.
+ */
+vector<Region> SkyTree::MapSharedToRegion() {
+  const uint32_t pruned = SHIFTS[NUM_DIMS] - 1;
+  const uint32_t num_threads = num_threads_ > 0 ? num_threads_ : 1;
+  const vector<float> min_list( NUM_DIMS, 0.0 );
+  const vector<float> max_list( NUM_DIMS, 1.0 );
+
+  PivotSelection selection( min_list, max_list, pivot_type_ );
+  const TupleIdx p = selection.Find( shared_, n_, num_threads );
+  const TUPLE &pivot = shared_[p];
+
+  const TupleIdx num = n_ - 1; // all but the pivot
+  KeyIndex* keys = AllocBuffer<KeyIndex>( num );
+#pragma omp parallel for num_threads(num_threads)
+  for (TupleIdx i = 0; i < num; i++) {
+    const TupleIdx j = i < p ? i : i + 1;
+    keys[i].key = EqualityTest( pivot, shared_[j] ) ? pruned + 1
+        : DT_bitmap_dvc( shared_[j], pivot );
+    keys[i].idx = j;
+  } // END PARALLEL FOR
+
+  /* Keep the points of the regions, and record those equal to the pivot
+   * in eqm_. */
+  TupleIdx kept = 0;
+  for (TupleIdx i = 0; i < num; i++) {
+    if ( keys[i].key < pruned )
+      keys[kept++] = keys[i];
+    else if ( keys[i].key > pruned )
+      eqm_.push_back( shared_[keys[i].idx].pid );
+  }
+  KeyIndex* scratch = AllocBuffer<KeyIndex>(
+      ParallelRadixSort::ScratchSize( kept, num_threads ) );
+  ParallelRadixSort::Sort( keys, kept, num_threads, scratch );
+  FreeBuffer( scratch );
+
+  data_ = AllocBuffer<TUPLE>( kept + 1 );
+  size_ = kept + 1;
+  data_[0] = pivot;
+#pragma omp parallel for num_threads(num_threads)
+  for (TupleIdx i = 0; i < kept; i++) {
+    data_[i + 1] = shared_[keys[i].idx];
+  } // END PARALLEL FOR
+
+  vector<Region> regions;
+  for (TupleIdx i = 0; i < kept;) {
+    Region region = { (uint32_t) keys[i].key, i + 1, 0 };
+    for (; i < kept && keys[i].key == region.lattice; i++)
+      ++region.size;
+    regions.push_back( region );
+  }
+  FreeBuffer( keys );
+  return regions;
+}
+
+bool SkyTree::PartialDominance_with_trees( const uint32_t lattice,
+    const FlatSkyTree& tree, const TupleIdx first_child,
+    const TupleIdx last_child, const TupleIdx right ) {
+
+  const TupleIdx last = tree.first_child[right] + tree.num_children[right];
+  for (TupleIdx c = tree.first_child[right]; c < last; ++c)
+    PartialDominance_with_trees( lattice, tree, first_child, last_child, c );
+
+  for (TupleIdx c = first_child; c < last_child; ++c) {
+    uint32_t cur_lattice = tree.lattice[c];
     if ( cur_lattice <= lattice ) {
       if ( (cur_lattice & lattice) == cur_lattice ) {
         if ( useTree_ ) {
-          if ( FilterPoint( right_tree.point, left_tree.children[c] ) ) {
-            dominated_[right_tree.point.pid] = true;
+          if ( FilterPoint( tree.point[right], tree, c ) ) {
+            dominated_[tree.point[right].pid] = true;
             return true;
           }
         } else {
-          if ( FilterPoint_without_skytree( right_tree.point,
-              left_tree.children[c] ) ) {
-            dominated_[right_tree.point.pid] = true;
+          if ( FilterPoint_without_skytree( tree.point[right], tree, c ) ) {
+            dominated_[tree.point[right].pid] = true;
             return true;
           }
         }
@@ -191,111 +482,167 @@ bool SkyTree::PartialDominance_with_trees( const uint32_t lattice,
   return false;
 }
 
-void SkyTree::PartialDominance( const uint32_t lattice, vector<TUPLE>& dataset,
-    Node& skytree ) {
-  const uint32_t num_child = skytree.children.size();
-
-  for (uint32_t c = 0; c < num_child; c++) {
-    uint32_t cur_lattice = skytree.children[c].lattice;
+/*
+ * Removes the points of dataset[0...size - 1] that are dominated by the
+ * children [first_child, last_child) of a node, and returns how many are
+ * left (at the front of dataset).
+ */
+TupleIdx SkyTree::PartialDominance( const uint32_t lattice, TUPLE* dataset,
+    TupleIdx size, const FlatSkyTree& tree, const TupleIdx first_child,
+    const TupleIdx last_child ) {
+
+  for (TupleIdx c = first_child; c < last_child; ++c) {
+    uint32_t cur_lattice = tree.lattice[c];
     if ( cur_lattice <= lattice ) {
       if ( (cur_lattice & lattice) == cur_lattice ) {
         // For each point, check whether the point is dominated by the existing skyline points.
-        vector<TUPLE>::iterator it = dataset.begin();
-        while ( it != dataset.end() ) {
+        TupleIdx i = 0;
+        while ( i < size ) {
           if ( useTree_ ) {
-            if ( FilterPoint( *it, skytree.children[c] ) ) {
-              *it = dataset.back();
-              dataset.pop_back();
-            } else
-              ++it;
+            if ( FilterPoint( dataset[i], tree, c ) )
+              dataset[i] = dataset[--size];
+            else
+              ++i;
           } else {
-            if ( FilterPoint_without_skytree( *it, skytree.children[c] ) ) {
-              *it = dataset.back();
-              dataset.pop_back();
-            } else
-              ++it;
+            if ( FilterPoint_without_skytree( dataset[i], tree, c ) )
+              dataset[i] = dataset[--size];
+            else
+              ++i;
           }
         }
 
-        if ( dataset.empty() )
+        if ( size == 0 )
           break;
+      } else {
+        COUNT_DT_SKIP( (uint64_t) tree.NumNodes( c, c + 1 ) * size );
       }
-    } else
+    } else {
+      COUNT_DT_SKIP( (uint64_t) tree.NumNodes( c, last_child ) * size );
       break;
+    }
+  }
+  return size;
+}
+
+/*
+ * Parallel variant of PartialDominance() against separately built 
+ * subtrees (sorted by lattice): filters chunks of SKYTREE_TASK_CUTOFF
+ * points of dataset as independent tasks (if there are several chunks)
+ * and then compacts the remaining points to the front. The points are
+ * flagged in the (now unused) lattice scratch space of their range.
+ */
+TupleIdx SkyTree::PartialDominanceParallel( const uint32_t lattice,
+    TUPLE* dataset, const TupleIdx size,
+    const vector<FlatSkyTree*>& subtrees ) {
+  uint32_t* const dominated = codes_ + (dataset - data_);
+  std::fill( dominated, dominated + size, 0 );
+  for (TupleIdx lo = 0; lo < size; lo += SKYTREE_TASK_CUTOFF) {
+#pragma omp task default(shared) firstprivate(lo) if(size >= 2 * SKYTREE_TASK_CUTOFF)
+    {
+      const TupleIdx hi =
+          lo + SKYTREE_TASK_CUTOFF < size ? lo + SKYTREE_TASK_CUTOFF : size;
+      for (uint32_t c = 0; c < subtrees.size(); c++) {
+        const uint32_t cur_lattice = subtrees[c]->lattice[0];
+        if ( cur_lattice > lattice ) {
+#if COUNT_DT==1
+          for (uint32_t r = c; r < subtrees.size(); r++)
+            COUNT_DT_SKIP( (uint64_t) subtrees[r]->NumNodes( 0, 1 ) * (hi - lo) );
+#endif
+          break;
+        }
+        if ( (cur_lattice & lattice) != cur_lattice ) {
+          COUNT_DT_SKIP( (uint64_t) subtrees[c]->NumNodes( 0, 1 ) * (hi - lo) );
+          continue;
+        }
+        for (TupleIdx i = lo; i < hi; ++i) {
+          if ( dominated[i] )
+            continue;
+          if ( useTree_ ? FilterPoint( dataset[i], *subtrees[c], 0 ) :
+              FilterPoint_without_skytree( dataset[i], *subtrees[c], 0 ) )
+            dominated[i] = 1;
+        }
+      }
+    } // END TASK
+  }
+#pragma omp taskwait
+
+  TupleIdx kept = 0;
+  for (TupleIdx i = 0; i < size; ++i) {
+    if ( !dominated[i] )
+      dataset[kept++] = dataset[i];
   }
+  return kept;
 }
 
 bool SkyTree::FilterPoint_without_skytree( const TUPLE &cur_value,
-    Node& skytree ) {
-  const uint32_t lattice = DT_bitmap_dvc( cur_value, skytree.point );
+    const FlatSkyTree& tree, const TupleIdx node ) {
+  const uint32_t lattice = DT_bitmap_dvc( cur_value, tree.point[node] );
   const uint32_t pruned = SHIFTS[NUM_DIMS] - 1;
 
   if ( lattice < pruned ) {
-    assert( !DominateLeft(skytree.point, cur_value) );
-    if ( skytree.children.size() > 0 ) {
-      const uint32_t num_child = skytree.children.size();
-      for (uint32_t c = 0; c < num_child; c++) {
-        if ( FilterPoint( cur_value, skytree.children[c] ) )
-          return true;
-      }
+    assert( !DominateLeft(tree.point[node], cur_value) );
+    const TupleIdx last = tree.first_child[node] + tree.num_children[node];
+    for (TupleIdx c = tree.first_child[node]; c < last; ++c) {
+      if ( FilterPoint( cur_value, tree, c ) )
+        return true;
     }
-    assert( !DominateLeft(skytree.point, cur_value) );
+    assert( !DominateLeft(tree.point[node], cur_value) );
     return false;
   }
-  assert( DominateLeft(skytree.point, cur_value) );
+  assert( DominateLeft(tree.point[node], cur_value) );
   return true;
 }
 
-bool SkyTree::FilterPoint( const TUPLE &cur_value, Node& skytree ) {
-  const uint32_t lattice = DT_bitmap_dvc( cur_value, skytree.point );
+bool SkyTree::FilterPoint( const TUPLE &cur_value, const FlatSkyTree& tree,
+    const TupleIdx node ) {
+  const uint32_t lattice = DT_bitmap_dvc( cur_value, tree.point[node] );
   const uint32_t pruned = SHIFTS[NUM_DIMS] - 1;
 
   if ( lattice < pruned ) {
-    assert( !DominateLeft(skytree.point, cur_value) );
-    if ( skytree.children.size() > 0 ) {
-      const uint32_t num_child = skytree.children.size();
-      for (uint32_t c = 0; c < num_child; c++) {
-        uint32_t cur_lattice = skytree.children[c].lattice;
-        if ( cur_lattice <= lattice ) {
-          if ( (cur_lattice & lattice) == cur_lattice ) {
-            if ( FilterPoint( cur_value, skytree.children[c] ) )
-              return true;
-          }
-        } else
-          break;
+    assert( !DominateLeft(tree.point[node], cur_value) );
+    const TupleIdx last = tree.first_child[node] + tree.num_children[node];
+    for (TupleIdx c = tree.first_child[node]; c < last; ++c) {
+      uint32_t cur_lattice = tree.lattice[c];
+      if ( cur_lattice <= lattice ) {
+        if ( (cur_lattice & lattice) == cur_lattice ) {
+          if ( FilterPoint( cur_value, tree, c ) )
+            return true;
+        } else {
+          COUNT_DT_SKIP( tree.NumNodes( c, c + 1 ) );
+        }
+      } else {
+        COUNT_DT_SKIP( tree.NumNodes( c, last ) );
+        break;
       }
     }
-    assert( !DominateLeft(skytree.point, cur_value) );
+    assert( !DominateLeft(tree.point[node], cur_value) );
     return false;
   }
-  assert( DominateLeft(skytree.point, cur_value) );
+  assert( DominateLeft(tree.point[node], cur_value) );
   return true;
 }
 
-void SkyTree::TraverseSkyTree( const Node& skytree ) {
-  if ( !useDnC_ || !dominated_[skytree.point.pid] )
-    skyline_.push_back( skytree.point.pid );
+void SkyTree::TraverseSkyTree( const FlatSkyTree& tree, const TupleIdx node ) {
+  // pre-order, skipping the unused child slots
+  if ( !useDnC_ || !dominated_[tree.point[node].pid] )
+    skyline_.push_back( tree.point[node].pid );
 
-  uint32_t num_child = skytree.children.size();
-  for (uint32_t c = 0; c < num_child; c++)
-    TraverseSkyTree( skytree.children[c] );
+  const TupleIdx last = tree.first_child[node] + tree.num_children[node];
+  for (TupleIdx c = tree.first_child[node]; c < last; ++c)
+    TraverseSkyTree( tree, c );
 }
 
 #ifndef NVERBOSE
-int SkyTree::MaxDepth( const Node& skytree, int d ) {
+int SkyTree::MaxDepth( const FlatSkyTree& tree, const TupleIdx node, int d ) {
   skytree_levels_[d]++;
 
-  if ( skytree.children.size() == 0 ) {
-    return 1;
-  } else {
-    int depth = MaxDepth( skytree.children[0], d + 1 );
-    for (uint32_t c = 1; c < skytree.children.size(); ++c) {
-      int h = MaxDepth( skytree.children[c], d + 1 );
-      if ( h > depth )
-        depth = h;
-    }
-
-    return depth + 1;
+  int depth = 0;
+  const TupleIdx last = tree.first_child[node] + tree.num_children[node];
+  for (TupleIdx c = tree.first_child[node]; c < last; ++c) {
+    int h = MaxDepth( tree, c, d + 1 );
+    if ( h > depth )
+      depth = h;
   }
+  return depth + 1;
 }
 #endif
@@ -4,6 +4,7 @@
 #include "bskytree/node.h"
 #include "bskytree/pivot_selection.h"
 #include "common/skyline_i.h"
+#include "common/shared_dataset.h"
 #include "common/common.h"
 
 #include <map>
@@ -11,45 +12,86 @@
 
 using namespace std;
 
+/* A subregion of the points of a SkyTree node, i.e., a range of the
+ * (lattice-sorted) data buffer. */
+typedef struct Region {
+	uint32_t lattice;
+	TupleIdx begin;
+	TupleIdx size;
+} Region;
+
 class SkyTree: public SkylineI {
 
 public:
-	SkyTree(const uint32_t n, const uint32_t d, float** dataset, 
-    const bool useTree, const bool useDnC );
+	SkyTree(const TupleIdx n, const uint32_t d, float** dataset, 
+    const bool useTree, const bool useDnC, const uint32_t num_threads = 0,
+    const uint32_t pivot_type = PIVOT_BALSKY );
 	~SkyTree(void);
 
 	void Init(float** dataset);
-	vector<int> Execute(void);
+	void InitShared(const SharedDataset &data);
+	vector<TupleId> Execute(void);
 
 private:
-	void ComputeSkyTree(const vector<float> min_list,
-			const vector<float> max_list, vector<TUPLE> &dataset,
-			Node& skytree );
+	void ComputeSkyTree(const vector<float> &min_list,
+			const vector<float> &max_list, TUPLE* dataset, TupleIdx size,
+			const uint32_t lattice, FlatSkyTree& tree, const TupleIdx node );
+	void ComputeChildren(const vector<float> &min_list,
+			const vector<float> &max_list, TUPLE* dataset,
+			const vector<Region> &regions, FlatSkyTree& tree,
+			const TupleIdx node );
+
+	void ComputeSkyTreeParallel(const vector<float> &min_list,
+			const vector<float> &max_list, TUPLE* dataset, TupleIdx size,
+			const uint32_t lattice, FlatSkyTree& tree, const TupleIdx node );
+	void ComputeChildrenParallel(const vector<float> &min_list,
+			const vector<float> &max_list, TUPLE* dataset,
+			const vector<Region> &regions, FlatSkyTree& tree,
+			const TupleIdx node );
 
-	map<uint32_t, vector<TUPLE> > MapPointToRegion(vector<TUPLE>& dataset);
+	vector<Region> MapPointToRegion(TUPLE* dataset, const TupleIdx size);
+	vector<Region> MapSharedToRegion();
+	void InitBuffers();
 
-  void PartialDominance(const uint32_t lattice, vector<TUPLE>& dataset,
-			Node& skytree );
-  bool PartialDominance_with_trees(const uint32_t lattice, Node& left_tree,
-      Node& right_tree );
-	bool FilterPoint(const TUPLE &cur_value, Node& skytree);
-  bool FilterPoint_without_skytree(const TUPLE &cur_value, Node& skytree);
-	void TraverseSkyTree(const Node& skytree);
+  TupleIdx PartialDominance(const uint32_t lattice, TUPLE* dataset,
+			TupleIdx size, const FlatSkyTree& tree, const TupleIdx first_child,
+			const TupleIdx last_child );
+  TupleIdx PartialDominanceParallel(const uint32_t lattice, TUPLE* dataset,
+			const TupleIdx size, const vector<FlatSkyTree*>& subtrees );
+  bool PartialDominance_with_trees(const uint32_t lattice,
+      const FlatSkyTree& tree, const TupleIdx first_child,
+      const TupleIdx last_child, const TupleIdx right );
+	bool FilterPoint(const TUPLE &cur_value, const FlatSkyTree& tree,
+			const TupleIdx node);
+  bool FilterPoint_without_skytree(const TUPLE &cur_value,
+      const FlatSkyTree& tree, const TupleIdx node);
+	void TraverseSkyTree(const FlatSkyTree& tree, const TupleIdx node);
 
 #ifndef NVERBOSE
-	int MaxDepth(const Node& skytree, int d);
+	int MaxDepth(const FlatSkyTree& tree, const TupleIdx node, int d);
 #endif
 
-	const uint32_t n_;
+	const TupleIdx n_;
 	const uint32_t d_;
-	vector<TUPLE> data_;
+	const uint32_t num_threads_; // 0 = sequential; else threads for task-parallel variant
+	const uint32_t pivot_type_; // PIVOT_*, see pivot_policy.h
+	const TUPLE* shared_; // the shared tuples, if not yet copied to data_
+	TUPLE* data_;
+	TupleIdx size_; // number of tuples in data_
+	/* Scratch space of MapPointToRegion(): for the points of data_[i...],
+	 * at scratch_[i...] (so that concurrent calls on disjoint ranges of
+	 * data_ do not overlap), and likewise for their lattices and sort
+	 * order. PartialDominanceParallel() reuses codes_ for its flags. */
+	TUPLE* scratch_;
+	uint32_t* codes_;
+	pair<uint32_t, TupleIdx>* order_;
 
 	vector<float> min_list_;
 	vector<float> max_list_;
 
-	Node skytree_;
-	vector<int> skyline_;
-	vector<int> eqm_; // "equivalence matrix"
+	FlatSkyTree skytree_;
+	vector<TupleId> skyline_;
+	vector<TupleId> eqm_; // "equivalence matrix"
   
   /* runtime params. */
   bool useTree_; //using SkyTree data structure in FilterPoints()
@@ -0,0 +1,82 @@
+/*
+ * arena.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "common/arena.h"
+
+#include "common/common.h"
+
+Arena::~Arena() {
+  FreeChunks();
+}
+
+void Arena::NewChunk( const size_t size ) {
+  Chunk c = { NULL, LargeSize( size, huge_ ), 0, PAGES_HEAP };
+  c.mem = (char*) AllocateLarge( c.size, huge_, c.kind );
+  chunks_.push_back( c );
+}
+
+void Arena::FreeChunks() {
+  for (uint32_t c = 0; c < chunks_.size(); ++c)
+    FreeLarge( chunks_[c].mem, chunks_[c].size, chunks_[c].kind );
+  chunks_.clear();
+}
+
+void* Arena::AllocateBytes( const size_t bytes ) {
+  const size_t size = (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+  /* Only the last chunk has room to bump: the others are full. */
+  if ( chunks_.empty() || chunks_.back().size - chunks_.back().used < size ) {
+    size_t chunk_size = chunks_.empty() ? ARENA_MIN_CHUNK
+        : 2 * chunks_.back().size;
+    if ( chunk_size < size )
+      chunk_size = size;
+    NewChunk( chunk_size );
+  }
+
+  Chunk &c = chunks_.back();
+  char* p = c.mem + c.used;
+  c.used += size;
+  return p;
+}
+
+void Arena::Reset() {
+  if ( chunks_.size() > 1 ) {
+    const size_t total = capacity();
+    FreeChunks();
+    NewChunk( total );
+  } else if ( !chunks_.empty() ) {
+    chunks_[0].used = 0;
+  }
+}
+
+size_t Arena::used() const {
+  size_t total = 0;
+  for (uint32_t c = 0; c < chunks_.size(); ++c)
+    total += chunks_[c].used;
+  return total;
+}
+
+size_t Arena::capacity() const {
+  size_t total = 0;
+  for (uint32_t c = 0; c < chunks_.size(); ++c)
+    total += chunks_[c].size;
+  return total;
+}
+
+size_t Arena::huge_bytes() const {
+  size_t total = 0;
+  for (uint32_t c = 0; c < chunks_.size(); ++c)
+    total += HugeBytes( chunks_[c].mem, chunks_[c].size, chunks_[c].kind );
+  return total;
+}
+
+size_t Arena::capacity( const PageKind kind ) const {
+  size_t total = 0;
+  for (uint32_t c = 0; c < chunks_.size(); ++c)
+    if ( chunks_[c].kind == kind )
+      total += chunks_[c].size;
+  return total;
+}
@@ -0,0 +1,94 @@
+/*
+ * arena.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Arena for the per-run buffers of the skyline algorithms: everything
+ *  sized by the number of tuples (tuple arrays, sort keys and scratch,
+ *  flags, staging buffers), while the skyline trees and result lists
+ *  stay on the heap. Buffers are bumped off large chunks and are all
+ *  released at once by Reset(), which keeps the memory for the next run.
+ *  After a run, the chunks are merged into one that fits everything the
+ *  run used, so that later runs of the same size allocate nothing (and
+ *  the pages are already faulted in). The chunks can be backed by huge
+ *  pages (see huge_pages.h).
+ *
+ *  Not thread-safe: allocate outside of parallel regions.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "common/huge_pages.h"
+
+using namespace std;
+
+class Arena {
+public:
+  /* If huge, allocates the chunks on huge pages where available. */
+  explicit Arena( const bool huge = false ) :
+      huge_( huge ) {
+  }
+  ~Arena();
+
+  /*
+   * Returns an uninitialised buffer of count T's, aligned to a cache
+   * line, which stays valid until the next Reset().
+   */
+  template<typename T>
+  inline T* Allocate( const size_t count ) {
+    return (T*) AllocateBytes( sizeof(T) * count );
+  }
+  void* AllocateBytes( const size_t bytes );
+
+  /* Releases all buffers, keeping (and merging) the chunks. */
+  void Reset();
+
+  /* Bytes allocated since the last Reset() (including alignment). */
+  size_t used() const;
+
+  /* Total size of the chunks, in bytes. */
+  size_t capacity() const;
+
+  /* Total size of the chunks backed by kind of pages, in bytes. */
+  size_t capacity( const PageKind kind ) const;
+
+  /* Bytes of the chunks currently backed by huge pages (see HugeBytes()). */
+  size_t huge_bytes() const;
+
+private:
+  Arena( const Arena& );
+  Arena& operator=( const Arena& );
+
+  struct Chunk {
+    char* mem;
+    size_t size;
+    size_t used;
+    PageKind kind;
+  };
+  void NewChunk( const size_t size );
+  void FreeChunks();
+
+  const bool huge_;
+  vector<Chunk> chunks_;
+};
+
+/*
+ * Returns count (uninitialised) T's from arena, if not NULL, and otherwise
+ * from the heap. Release with ReleaseIn() on the same arena.
+ */
+template<typename T>
+inline T* AllocateIn( Arena* arena, const size_t count ) {
+  return arena != NULL ? arena->Allocate<T>( count ) : new T[count];
+}
+template<typename T>
+inline void ReleaseIn( Arena* arena, T* buffer ) {
+  if ( arena == NULL )
+    delete[] buffer;
+}
+
+#endif /* ARENA_H_ */
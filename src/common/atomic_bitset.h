@@ -0,0 +1,104 @@
+/*
+ * atomic_bitset.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  A fixed-size bitset that threads may test and set concurrently. All
+ *  accesses are relaxed atomics: a flag only ever goes from clear to set
+ *  while threads share it, so no ordering is needed beyond the barriers
+ *  that already separate the phases of an algorithm. Packs 64 flags per
+ *  word, rather than one flag per byte (as a bool array does).
+ */
+
+#ifndef ATOMIC_BITSET_H_
+#define ATOMIC_BITSET_H_
+
+#include <stdint.h>
+#include <cstring>
+
+#include "common/common.h"
+
+class AtomicBitset {
+public:
+  /* An empty bitset, until Reset(). */
+  AtomicBitset() :
+      num_words_( 0 ), words_( NULL ) {
+  }
+
+  /* Number of words of storage that n flags take. */
+  static inline TupleIdx NumWords( const TupleIdx n ) {
+    return n > 0 ? (n + 63) / 64 : 1;
+  }
+
+  /*
+   * Keeps n flags, all cleared, in words (of at least NumWords( n )
+   * words), which the caller owns, so that it can be reused across runs
+   * (see Arena).
+   */
+  void Reset( uint64_t* words, const TupleIdx n ) {
+    num_words_ = (n + 63) / 64;
+    words_ = words;
+    ClearAll();
+  }
+
+  inline bool Test( const TupleIdx i ) const {
+    return (__atomic_load_n( &words_[i >> 6], __ATOMIC_RELAXED )
+        >> (i & 63)) & 1;
+  }
+
+  inline void Set( const TupleIdx i ) {
+    __atomic_fetch_or( &words_[i >> 6], (uint64_t) 1 << (i & 63),
+        __ATOMIC_RELAXED );
+  }
+
+  /* Returns the index of the first set flag in [from, end), or end. */
+  inline TupleIdx FindFirst( const TupleIdx from, const TupleIdx end ) const {
+    if ( from >= end )
+      return end;
+    TupleIdx w = from >> 6;
+    uint64_t word = __atomic_load_n( &words_[w], __ATOMIC_RELAXED )
+        & (~(uint64_t) 0 << (from & 63));
+    while ( word == 0 ) {
+      if ( ++w > (end - 1) >> 6 )
+        return end;
+      word = __atomic_load_n( &words_[w], __ATOMIC_RELAXED );
+    }
+    const TupleIdx i = (w << 6) + __builtin_ctzll( word );
+    return i < end ? i : end;
+  }
+
+  /* Clears the whole word w, i.e., the flags 64 * w...64 * w + 63. */
+  inline void ClearWord( const TupleIdx w ) {
+    __atomic_store_n( &words_[w], (uint64_t) 0, __ATOMIC_RELAXED );
+  }
+
+  /* Not thread-safe. */
+  void ClearAll() {
+    memset( words_, 0, sizeof(uint64_t) * num_words_ );
+  }
+
+private:
+  AtomicBitset( const AtomicBitset& );
+  AtomicBitset& operator=( const AtomicBitset& );
+
+  TupleIdx num_words_;
+  uint64_t* words_;
+};
+
+/*
+ * Keeps tuples whose flag in a bitset is clear, for ParallelCompactor.
+ * The bitset is indexed by offset + the index into the source array.
+ */
+struct BitIsClear {
+  BitIsClear( const AtomicBitset &bits, const TupleIdx offset ) :
+      bits_( bits ), offset_( offset ) {
+  }
+  template<typename T>
+  inline bool operator()( const T &t, const TupleIdx i ) const {
+    return !bits_.Test( offset_ + i );
+  }
+  const AtomicBitset &bits_;
+  const TupleIdx offset_;
+};
+
+#endif /* ATOMIC_BITSET_H_ */
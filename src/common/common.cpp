@@ -10,3 +10,4 @@
 uint64_t dt_count = 0;
 uint64_t dt_count_incomp = 0;
 uint64_t dt_count_dom = 0;
+uint64_t dt_count_skip = 0;
@@ -21,8 +21,21 @@
 #define DOM_INCOMP  2
 #define P_ACCUM 256
 #define BSKYTREE_ACCUM 256
+#define BSKYTREE_REPIVOT 128 // min. points for a partition to get its own pivot
+#define BSKYTREE_REPIVOT_DIMS 10 // min. dimensionality for re-pivoting at all
+#define SKYTREE_TASK_CUTOFF 1024 // min. points for a region to spawn tasks
+#define PIVOT_PARALLEL_MIN 4096 // min. points to select a pivot in parallel
 #define DEFAULT_ALPHA 1024 // previous Q_ACCUM
 #define DEFAULT_QP_SIZE 8
+#define SAMPLE_FILTER_MIN 64 // min. sample size for the sample-skyline filter
+#define GRID_MAX_BUCKETS 64 // max. buckets per dimension of the grid filter
+#define GRID_MAX_ROWS (1 << 18) // max. B-bit rows (B^(d-1)) of the grid filter
+#define GRID_HIST_BINS 1024 // fine histogram bins per dimension of the grid filter
+#define DEFAULT_SPLIT_SIZE 64 // max. linearly scanned points per partition
+#define DEFAULT_MAX_DEPTH 8 // max. levels of (recursive) partitioning
+#define ARENA_MIN_CHUNK (1 << 20) // size of the first chunk of an Arena
+#define ARENA_ALIGN 64 // alignment of Arena buffers (a cache line)
+#define HUGE_PAGE_SIZE (2 << 20) // size of a huge page (see huge_pages.h)
 
 #define PRUNED (NUM_DIMS << 2)
 #define ALL_ONES ((1<<NUM_DIMS) - 1)
@@ -36,6 +49,44 @@
 #define PIVOT_MANHATTAN 4     
 #define PIVOT_VOLUME 5     // BSkyTree.MaxDom
 
+// Number of tuples sampled to select a pivot. By the DKW inequality, every
+// per-dimension quantile of a uniform sample of this size is within 1% of
+// the true quantile with probability at least 99.9%.
+#define PIVOT_SAMPLE_SIZE 38005
+
+/*
+ * Tuple ids (TUPLE::pid, and so the skyline results) and tuple indexes and
+ * counts: 32-bit by default, or 64-bit for inputs of more than 2^31
+ * tuples if compiled with ID_BITS=64 (make IDS=64).
+ */
+#if ID_BITS == 64
+typedef int64_t TupleId;
+typedef uint64_t TupleIdx;
+#else
+typedef int32_t TupleId;
+typedef uint32_t TupleIdx;
+#endif
+
+#define RANDOM_SEED 2463534242u // seed of NextRandom() sequences
+
+/*
+ * Advances the fixed-seed xorshift generator x (Marsaglia, 2003) and
+ * returns its next value, which is as wide as a TupleIdx, so that every
+ * tuple index can be drawn.
+ */
+inline TupleIdx NextRandom( TupleIdx &x ) {
+#if ID_BITS == 64
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+#else
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+#endif
+  return x;
+}
+
 static const uint32_t SHIFTS[] = { 1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1
     << 5, 1 << 6, 1 << 7, 1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12, 1 << 13, 1
     << 14, 1 << 15, 1 << 16, 1 << 17, 1 << 18, 1 << 19, 1 << 20, 1 << 21, 1
@@ -44,7 +95,7 @@ static const uint32_t SHIFTS[] = { 1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1
 
 typedef struct TUPLE {
   float elems[NUM_DIMS];
-  int pid;
+  TupleId pid;
 //  TUPLE(const int id, float* data): pid(id) {
 //    for (uint32_t d = 0; d < NUM_DIMS; ++d) {
 //      elems[d] = data[d];
@@ -72,8 +123,10 @@ typedef struct STUPLE: TUPLE {
 
 typedef struct TUPLE_S: TUPLE {
   uint32_t partition; // bitset: 0 is <= pivot, 1 is > pivot
+  uint32_t sub_partition; // same, w.r.t. the pivot of its partition (if any)
+  TUPLE_S() { }
   TUPLE_S(const TUPLE t, const uint32_t p):
-    TUPLE(t), partition(p) { }
+    TUPLE(t), partition(p), sub_partition(0) { }
 } TUPLE_S;
 
 // Partition-based Tuple
@@ -168,6 +221,13 @@ typedef struct EPTUPLE: STUPLE {
 extern uint64_t dt_count;
 extern uint64_t dt_count_dom;
 extern uint64_t dt_count_incomp;
+extern uint64_t dt_count_skip; // DTs saved by region-level (bitmap) pruning
+
+#if COUNT_DT==1
+#define COUNT_DT_SKIP( k ) __sync_fetch_and_add( &dt_count_skip, (uint64_t) (k) )
+#else
+#define COUNT_DT_SKIP( k )
+#endif
 
 // returns the maximum attribute value
 inline float get_max(const STUPLE &p) {
@@ -456,19 +516,6 @@ inline bool EqualityTest(const TUPLE &t1, const TUPLE &t2) {
   return eq;
 }
 
-inline float calc_norm_range ( const TUPLE &t, const float *mins, const float *ranges ) {
-  float min, max;
-  min = max = ( t.elems[0] - mins[0] ) / ranges[0];
-  for (uint32_t j = 1; j < NUM_DIMS; j++) {
-    const float v_norm = ( t.elems[j] - mins[j] ) / ranges[j];
-    if ( min > v_norm )
-      min = v_norm;
-    else if ( max < v_norm )
-      max = v_norm;
-  }
-  return max - min;
-}
-
 /* Below code is replicated, but these versions are needed 
  * for micro-benchmarking different types of DTs.
  */
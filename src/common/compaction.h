@@ -0,0 +1,179 @@
+/*
+ * compaction.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Parallel, stable compaction of tuple arrays (i.e., a parallel
+ *  stable partition that keeps only the first part). Replaces the
+ *  sequential sort/copy loops that remove pruned tuples between the
+ *  phases of the block-based algorithms.
+ */
+
+#ifndef COMPACTION_H_
+#define COMPACTION_H_
+
+#include <stdint.h>
+
+#include <cassert>
+#include <algorithm>
+
+#include "common/common.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#define omp_get_num_threads() 1
+#endif
+
+/*
+ * Keeps tuples that have not been marked as pruned.
+ */
+template<typename T>
+struct NotPruned {
+  inline bool operator()( const T &t, const TupleIdx i ) const {
+    return !t.isPruned();
+  }
+};
+
+/*
+ * Keeps tuples whose entry in a parallel flag array has a given value.
+ * The flag array is indexed like the source array of Compact().
+ */
+template<typename F>
+struct FlagIs {
+  FlagIs( const F* flags, const F value ) :
+      flags_( flags ), value_( value ) {
+  }
+  template<typename T>
+  inline bool operator()( const T &t, const TupleIdx i ) const {
+    return flags_[i] == value_;
+  }
+  const F* flags_;
+  const F value_;
+};
+
+template<typename T>
+class ParallelCompactor {
+public:
+  ParallelCompactor( const uint32_t num_threads, const TupleIdx capacity ) :
+      num_threads_( num_threads ), capacity_( capacity ), owned_( true ) {
+    buffer_ = new T[capacity];
+    counts_ = new TupleIdx[num_threads];
+  }
+
+  /* Without a buffer, until SetBuffer(). */
+  explicit ParallelCompactor( const uint32_t num_threads ) :
+      num_threads_( num_threads ), capacity_( 0 ), owned_( false ),
+      buffer_( NULL ) {
+    counts_ = new TupleIdx[num_threads];
+  }
+
+  ~ParallelCompactor() {
+    if ( owned_ )
+      delete[] buffer_;
+    delete[] counts_;
+  }
+
+  /*
+   * Stages in buffer, of capacity T's, which the caller owns (so that it
+   * can be reused across runs, see Arena).
+   */
+  void SetBuffer( T* buffer, const TupleIdx capacity ) {
+    assert( !owned_ );
+    buffer_ = buffer;
+    capacity_ = capacity;
+  }
+
+  /*
+   * Copies all tuples src[i] with keep(src[i], i) to dst[0...], preserving
+   * their relative order, and returns how many were kept. src and dst may
+   * overlap (e.g., dst == src for in-place compaction), as long as
+   * dst <= src.
+   *
+   * Since tuples only move down, a thread's chunk can only be overwritten
+   * by the outputs of the threads after it. Just the survivors in that
+   * window are staged in buffer_; the others are moved directly.
+   *
+   * Must be called by every thread of the enclosing parallel region with
+   * the same arguments (or outside of any parallel region, in which case
+   * it runs sequentially). Every caller gets the same return value.
+   */
+  template<typename Keep>
+  TupleIdx Compact( const T* src, const TupleIdx n, T* dst, const Keep &keep );
+
+private:
+  const uint32_t num_threads_;
+  TupleIdx capacity_;
+  const bool owned_; /**< Whether buffer_ was allocated by the constructor */
+  T* buffer_; /**< Staging area, for the survivors that dst may overwrite */
+  TupleIdx* counts_; /**< Number of kept tuples per thread */
+};
+
+// Templated member function has to be defined in a header file..
+
+template<typename T>
+template<typename Keep>
+TupleIdx ParallelCompactor<T>::Compact( const T* src, const TupleIdx n, T* dst,
+    const Keep &keep ) {
+  const uint32_t nt = omp_get_num_threads();
+  const uint32_t th = omp_get_thread_num();
+  assert( n <= capacity_ );
+  assert( nt <= num_threads_ );
+  assert( dst <= src );
+
+  /* Each thread counts survivors in its own static chunk. */
+  const TupleIdx lo = (uint64_t) n * th / nt;
+  const TupleIdx hi = (uint64_t) n * (th + 1) / nt;
+  TupleIdx cnt = 0;
+  for (TupleIdx i = lo; i < hi; ++i) {
+    if ( keep( src[i], i ) )
+      ++cnt;
+  }
+  counts_[th] = cnt;
+#pragma omp barrier
+
+  /* Exclusive prefix sum gives each chunk its output offset. */
+  TupleIdx offset = 0, total = 0;
+  for (uint32_t t = 0; t < nt; ++t) {
+    if ( t == th )
+      offset = total;
+    total += counts_[t];
+  }
+
+  /* Stage the survivors in src[wlo...whi - 1], the part of this chunk
+   * that the outputs of the next threads, dst[offset + cnt...total - 1],
+   * cover. */
+  TupleIdx wlo = hi, whi = hi;
+  if ( th + 1 < nt ) {
+    const T* const next_lo = dst + offset + cnt;
+    const T* const next_hi = dst + total;
+    wlo = next_lo <= src + lo ? lo : next_lo < src + hi ? next_lo - src : hi;
+    whi = next_hi >= src + hi ? hi : next_hi > src + wlo ? next_hi - src : wlo;
+  }
+  TupleIdx num_staged = 0;
+  for (TupleIdx i = wlo; i < whi; ++i) {
+    if ( keep( src[i], i ) )
+      buffer_[offset + num_staged++] = src[i];
+  }
+#pragma omp barrier
+
+  /* Move the other survivors directly (never ahead of the reads of this
+   * chunk) and the staged ones in between. */
+  TupleIdx out = offset;
+  for (TupleIdx i = lo; i < wlo; ++i) {
+    if ( keep( src[i], i ) )
+      dst[out++] = src[i];
+  }
+  std::copy( buffer_ + offset, buffer_ + offset + num_staged, dst + out );
+  out += num_staged;
+  for (TupleIdx i = whi; i < hi; ++i) {
+    if ( keep( src[i], i ) )
+      dst[out++] = src[i];
+  }
+#pragma omp barrier
+
+  return total;
+}
+
+#endif /* COMPACTION_H_ */
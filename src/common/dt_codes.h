@@ -0,0 +1,103 @@
+/*
+ * dt_codes.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Dominance tests on rank-coded tuples (see RankTransform), i.e., on
+ *  uint8_t or uint16_t dense ranks rather than float values. A 128-bit
+ *  compare covers 16 (resp. 8) dimensions, rather than 4 floats, and
+ *  ties are exact, so that no distinct value condition is needed.
+ *
+ *  Uses SSE4.1 (unsigned epi8/epi16 max) when available; the build only
+ *  enables AVX, which has no 256-bit integer compares.
+ */
+
+#ifndef DT_CODES_H_
+#define DT_CODES_H_
+
+#include <stdint.h>
+
+#if __SSE4_1__
+#include <smmintrin.h>  // SSE4.1
+#endif
+
+#include "common/common.h"
+
+/*
+ * Rank-coded tuple: the code of each dimension, padded with zeros to a
+ * multiple of 16 bytes (zeros compare equal, so they never affect
+ * dominance), and the id of the tuple.
+ */
+template<typename C>
+struct CTUPLE {
+  static const uint32_t LANES = 16 / sizeof(C);
+  static const uint32_t PADDED = (NUM_DIMS + LANES - 1) / LANES * LANES;
+
+  C codes[PADDED];
+  TupleId pid;
+};
+
+#if __SSE4_1__
+/* Lane-wise unsigned max of 16 uint8_t or 8 uint16_t codes. */
+template<typename C>
+inline __m128i MaxCodes( const __m128i a, const __m128i b );
+
+template<>
+inline __m128i MaxCodes<uint8_t>( const __m128i a, const __m128i b ) {
+  return _mm_max_epu8( a, b );
+}
+
+template<>
+inline __m128i MaxCodes<uint16_t>( const __m128i a, const __m128i b ) {
+  return _mm_max_epu16( a, b );
+}
+#endif
+
+/*
+ * One-way dominance test on rank-coded tuples: true iff t1 is <= t2 in
+ * every dimension and < in at least one.
+ */
+template<typename C>
+inline bool DominateLeft( const CTUPLE<C> &t1, const CTUPLE<C> &t2 ) {
+#if COUNT_DT==1
+  __sync_fetch_and_add( &dt_count, 1 );
+#endif
+  bool strict = false;
+
+#if __SSE4_1__
+  for (uint32_t k = 0; k < CTUPLE<C>::PADDED; k += CTUPLE<C>::LANES) {
+    const __m128i a = _mm_loadu_si128( (const __m128i *) (t1.codes + k) );
+    const __m128i b = _mm_loadu_si128( (const __m128i *) (t2.codes + k) );
+
+    /* a <= b iff max(a, b) == b; byte-wise equality suffices. */
+    if ( _mm_movemask_epi8( _mm_cmpeq_epi8( MaxCodes<C>( a, b ), b ) )
+        != 0xFFFF ) {
+#if COUNT_DT==1
+      __sync_fetch_and_add( &dt_count_incomp, 1 );
+#endif
+      return false; // Points are incomparable.
+    }
+    strict |= _mm_movemask_epi8( _mm_cmpeq_epi8( a, b ) ) != 0xFFFF;
+  }
+#else
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    if ( t1.codes[j] > t2.codes[j] ) {
+#if COUNT_DT==1
+      __sync_fetch_and_add( &dt_count_incomp, 1 );
+#endif
+      return false; // Points are incomparable.
+    }
+    strict |= t1.codes[j] < t2.codes[j];
+  }
+#endif
+
+#if COUNT_DT==1
+  if ( strict )
+    __sync_fetch_and_add( &dt_count_dom, 1 );
+  else
+    __sync_fetch_and_add( &dt_count_incomp, 1 );
+#endif
+  return strict; // (Points are equal if not strict.)
+}
+
+#endif /* DT_CODES_H_ */
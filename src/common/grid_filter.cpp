@@ -0,0 +1,185 @@
+/*
+ * grid_filter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "common/grid_filter.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "common/common.h"
+
+/* Fine histogram bin of x, given the minimum and the scale (bins per unit)
+ * of its dimension. Monotone in x, so that a smaller bin (and therefore a
+ * smaller bucket) implies a strictly smaller value. */
+static inline uint32_t FineBin( const float x, const float min,
+    const float scale ) {
+  const uint32_t f = (uint32_t) ((x - min) * scale);
+  return f < GRID_HIST_BINS ? f : GRID_HIST_BINS - 1;
+}
+
+/* Every cell index (row << 6 | c_0) must fit in 32 bits. */
+static_assert( (uint64_t) GRID_MAX_ROWS << 6 <= UINT32_MAX,
+    "GRID_MAX_ROWS too large for 32-bit cell indexes" );
+
+/*
+ * The number of buckets per dimension: the largest B (up to
+ * GRID_MAX_BUCKETS) for which the grid has at most GRID_MAX_ROWS rows
+ * (i.e., lines along the first dimension), or 1 if even B = 2 has too
+ * many rows (2^(d-1) > GRID_MAX_ROWS), in which case no grid is built.
+ */
+uint32_t GridFilter::NumBuckets() {
+  uint32_t b = 1;
+  while ( b < GRID_MAX_BUCKETS ) {
+    uint64_t rows = 1;
+    for (uint32_t j = 1; j < NUM_DIMS && rows <= GRID_MAX_ROWS; ++j)
+      rows *= b + 1;
+    if ( rows > GRID_MAX_ROWS )
+      break;
+    ++b;
+  }
+  return b;
+}
+
+vector<TupleIdx> GridFilter::Execute( float** data, const TupleIdx n,
+    const uint32_t num_threads ) {
+  vector<TupleIdx> ids;
+  if ( n == 0 )
+    return ids;
+
+  /* Too many dimensions for even a 2^d grid: nothing is eliminated. */
+  const uint32_t B = NumBuckets();
+  if ( B < 2 ) {
+    ids.resize( n );
+    for (TupleIdx i = 0; i < n; ++i)
+      ids[i] = i;
+    return ids;
+  }
+  const uint32_t H = GRID_HIST_BINS;
+
+  /* Find the bounds of each dimension. */
+  float mins[NUM_DIMS], maxs[NUM_DIMS], scales[NUM_DIMS];
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    mins[j] = maxs[j] = data[0][j];
+  }
+#pragma omp parallel num_threads(num_threads)
+  {
+    float th_mins[NUM_DIMS], th_maxs[NUM_DIMS];
+    for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+      th_mins[j] = th_maxs[j] = data[0][j];
+    }
+#pragma omp for nowait
+    for (TupleIdx i = 0; i < n; ++i) {
+      for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+        th_mins[j] = std::min( th_mins[j], data[i][j] );
+        th_maxs[j] = std::max( th_maxs[j], data[i][j] );
+      }
+    } // END PARALLEL FOR
+#pragma omp critical
+    {
+      for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+        mins[j] = std::min( mins[j], th_mins[j] );
+        maxs[j] = std::max( maxs[j], th_maxs[j] );
+      }
+    } // END CRITICAL
+  } // END PARALLEL
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    const float range = maxs[j] - mins[j];
+    scales[j] = range > 0 ? H / range : 0;
+  }
+
+  /* Build a histogram of fine bins per dimension, with one per thread. */
+  vector<TupleIdx> hist( NUM_DIMS * H, 0 );
+#pragma omp parallel num_threads(num_threads)
+  {
+    vector<TupleIdx> local( NUM_DIMS * H, 0 );
+#pragma omp for nowait
+    for (TupleIdx i = 0; i < n; ++i) {
+      for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+        ++local[j * H + FineBin( data[i][j], mins[j], scales[j] )];
+      }
+    } // END PARALLEL FOR
+#pragma omp critical
+    {
+      for (uint32_t k = 0; k < NUM_DIMS * H; ++k)
+        hist[k] += local[k];
+    } // END CRITICAL
+  } // END PARALLEL
+
+  /* Merge fine bins into B buckets of (roughly) n / B tuples each. */
+  vector<uint8_t> bucket( NUM_DIMS * H );
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    uint64_t cum = 0;
+    uint32_t b = 0;
+    for (uint32_t h = 0; h < H; ++h) {
+      bucket[j * H + h] = b;
+      cum += hist[j * H + h];
+      while ( b + 1 < B && cum * B >= (uint64_t) (b + 1) * n )
+        ++b;
+    }
+  }
+
+  /* Mark the occupied cells. Cell (c_0, ..., c_{d-1}) is bit c_0 of row
+   * c_1 + c_2 * B + ... + c_{d-1} * B^{d-2}. */
+  uint32_t rows = 1;
+  for (uint32_t j = 1; j < NUM_DIMS; ++j)
+    rows *= B;
+  vector<uint64_t> grid( rows, 0 );
+  uint32_t* cells = new uint32_t[n];
+#pragma omp parallel for num_threads(num_threads)
+  for (TupleIdx i = 0; i < n; ++i) {
+    uint32_t row = 0;
+    for (uint32_t j = NUM_DIMS - 1; j > 0; --j) {
+      row = row * B + bucket[j * H + FineBin( data[i][j], mins[j], scales[j] )];
+    }
+    const uint32_t c0 = bucket[FineBin( data[i][0], mins[0], scales[0] )];
+    const uint64_t bit = (uint64_t) 1 << c0;
+    if ( !(__atomic_load_n( &grid[row], __ATOMIC_RELAXED ) & bit) )
+      __atomic_fetch_or( &grid[row], bit, __ATOMIC_RELAXED );
+    cells[i] = (row << 6) | c0;
+  } // END PARALLEL FOR
+
+  /* Prefix OR along dimensions 1...d-1, line by line: afterwards, row r
+   * holds the union of all rows that are <= r in each of those dims. */
+  uint32_t stride = 1, offset = 0;
+  for (uint32_t j = 1; j < NUM_DIMS; ++j) {
+#pragma omp parallel for num_threads(num_threads)
+    for (uint32_t q = 0; q < rows / B; ++q) {
+      const uint32_t base = (q / stride) * stride * B + q % stride;
+      for (uint32_t c = 1; c < B; ++c)
+        grid[base + c * stride] |= grid[base + (c - 1) * stride];
+    } // END PARALLEL FOR
+    offset += stride;
+    stride *= B;
+  }
+
+  /* A cell is eliminated iff the cell one below it in every dimension
+   * is at or above an occupied cell, i.e., iff the prefix OR (now also
+   * along dimension 0) of row r - offset has bit c_0 - 1 set. */
+  vector<uint64_t> dominated( rows, 0 );
+#pragma omp parallel for num_threads(num_threads)
+  for (uint32_t r = 0; r < rows; ++r) {
+    bool inner = true;
+    for (uint32_t s = 1; s < rows && inner; s *= B)
+      inner = (r / s) % B != 0;
+    if ( inner ) {
+      uint64_t x = grid[r - offset];
+      for (uint32_t shift = 1; shift < 64; shift <<= 1)
+        x |= x << shift;
+      dominated[r] = x << 1;
+    }
+  } // END PARALLEL FOR
+
+  /* Keep the tuples in cells that are not eliminated. */
+  ids.reserve( n );
+  for (TupleIdx i = 0; i < n; ++i) {
+    if ( !((dominated[cells[i] >> 6] >> (cells[i] & 63)) & 1) )
+      ids.push_back( i );
+  }
+  delete[] cells;
+
+  return ids;
+}
@@ -0,0 +1,44 @@
+/*
+ * grid_filter.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Skyline filter based on a grid. Each dimension is quantised into B
+ *  buckets of (roughly) equal depth, found from parallel histograms, and
+ *  the occupied grid cells are marked. A cell that is strictly below an
+ *  occupied cell in every dimension contains only dominated tuples, so
+ *  such cells are eliminated without any dominance test.
+ *
+ *  The occupancy grid is stored as one B-bit word per line along the
+ *  first dimension, so that eliminating the dominated cells is a prefix
+ *  OR along each dimension, done word-wise (or, within a word, by
+ *  shifts), followed by a shift by one cell in every dimension.
+ */
+
+#ifndef GRID_FILTER_H_
+#define GRID_FILTER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "common/common.h"
+
+using namespace std;
+
+class GridFilter {
+public:
+
+  /*
+   * Returns the (ascending) indexes of the tuples of data, n rows of
+   * NUM_DIMS values, that do not lie in an eliminated grid cell, using
+   * num_threads threads. Every tuple not returned is dominated.
+   */
+  static vector<TupleIdx> Execute( float** data, const TupleIdx n,
+      const uint32_t num_threads );
+
+private:
+  static uint32_t NumBuckets();
+};
+
+#endif /* GRID_FILTER_H_ */
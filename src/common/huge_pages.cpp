@@ -0,0 +1,107 @@
+/*
+ * huge_pages.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "common/huge_pages.h"
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+#include "common/common.h"
+
+static inline size_t RoundUp( const size_t x, const size_t to ) {
+  return (x + to - 1) / to * to;
+}
+
+size_t LargeSize( const size_t bytes, const bool huge ) {
+  return huge ? RoundUp( bytes, HUGE_PAGE_SIZE ) : bytes;
+}
+
+void* AllocateLarge( const size_t bytes, const bool huge, PageKind &kind ) {
+  if ( !huge ) {
+    void* mem = NULL;
+    if ( posix_memalign( &mem, ARENA_ALIGN, bytes ) != 0 )
+      throw std::bad_alloc();
+    kind = PAGES_HEAP;
+    return mem;
+  }
+
+  const size_t size = LargeSize( bytes, huge );
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+  void* mem = mmap( NULL, size, prot, flags | MAP_HUGETLB, -1, 0 );
+  if ( mem != MAP_FAILED ) {
+    kind = PAGES_HUGETLB;
+    return mem;
+  }
+#endif
+
+  /* Map one huge page more than needed and trim the ends, so that the
+   * buffer is aligned to a huge page (as THP requires). */
+  char* raw = (char*) mmap( NULL, size + HUGE_PAGE_SIZE, prot, flags, -1, 0 );
+  if ( raw == (char*) MAP_FAILED )
+    throw std::bad_alloc();
+  char* aligned = (char*) RoundUp( (uintptr_t) raw, HUGE_PAGE_SIZE );
+  if ( aligned > raw )
+    munmap( raw, aligned - raw );
+  munmap( aligned + size, raw + HUGE_PAGE_SIZE - aligned );
+
+  kind = PAGES_SMALL;
+#ifdef MADV_HUGEPAGE
+  if ( madvise( aligned, size, MADV_HUGEPAGE ) == 0 )
+    kind = PAGES_TRANSPARENT;
+#endif
+  return aligned;
+}
+
+void FreeLarge( void* mem, const size_t bytes, const PageKind kind ) {
+  if ( kind == PAGES_HEAP )
+    free( mem );
+  else
+    munmap( mem, LargeSize( bytes, true ) );
+}
+
+size_t HugeBytes( const void* mem, const size_t bytes, const PageKind kind ) {
+  if ( kind == PAGES_HUGETLB )
+    return LargeSize( bytes, true );
+  if ( kind != PAGES_TRANSPARENT )
+    return 0;
+
+  /* Sum AnonHugePages over the mappings that overlap the buffer. */
+  FILE* f = fopen( "/proc/self/smaps", "r" );
+  if ( f == NULL )
+    return 0;
+  const uintptr_t lo = (uintptr_t) mem;
+  const uintptr_t hi = lo + LargeSize( bytes, true );
+  bool overlaps = false;
+  size_t huge = 0;
+  char line[256];
+  while ( fgets( line, sizeof(line), f ) != NULL ) {
+    unsigned long start, end, kb;
+    if ( sscanf( line, "%lx-%lx ", &start, &end ) == 2 )
+      overlaps = start < hi && end > lo;
+    else if ( overlaps && sscanf( line, "AnonHugePages: %lu kB", &kb ) == 1 )
+      huge += kb * 1024;
+  }
+  fclose( f );
+  return huge < hi - lo ? huge : hi - lo;
+}
+
+const char* PageKindName( const PageKind kind ) {
+  switch ( kind ) {
+  case PAGES_SMALL:
+    return "small (no huge pages available)";
+  case PAGES_TRANSPARENT:
+    return "transparent huge (advised)";
+  case PAGES_HUGETLB:
+    return "huge (hugetlb)";
+  default:
+    return "heap";
+  }
+}
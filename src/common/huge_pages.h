@@ -0,0 +1,48 @@
+/*
+ * huge_pages.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Allocation of large buffers (tuple arrays) on 2 MB pages, to cut the
+ *  TLB misses of scanning them. Explicit huge pages (MAP_HUGETLB) are
+ *  only available if the administrator has reserved some, so the fallback
+ *  is a 2 MB-aligned mapping advised for transparent huge pages
+ *  (MADV_HUGEPAGE), which the kernel may or may not honour.
+ */
+
+#ifndef HUGE_PAGES_H_
+#define HUGE_PAGES_H_
+
+#include <stddef.h>
+
+enum PageKind {
+  PAGES_HEAP, // plain heap allocation (huge pages not requested)
+  PAGES_SMALL, // mapped, but neither kind of huge page was available
+  PAGES_TRANSPARENT, // mapped and advised for transparent huge pages
+  PAGES_HUGETLB // mapped on explicit (reserved) huge pages
+};
+
+/*
+ * Allocates bytes aligned to (at least) a cache line. If huge, maps them
+ * on huge pages if possible (rounding the size up to HUGE_PAGE_SIZE) and
+ * sets kind to the backing obtained; otherwise, allocates them from the
+ * heap. Throws std::bad_alloc on failure.
+ */
+void* AllocateLarge( const size_t bytes, const bool huge, PageKind &kind );
+
+/* Frees mem, as allocated by AllocateLarge( bytes, ..., kind ). */
+void FreeLarge( void* mem, const size_t bytes, const PageKind kind );
+
+/*
+ * Returns how many of the bytes at mem (as allocated by AllocateLarge()
+ * with kind) are currently backed by huge pages. For transparent huge
+ * pages, this is read from /proc/self/smaps (0 if unavailable).
+ */
+size_t HugeBytes( const void* mem, const size_t bytes, const PageKind kind );
+
+/* The size that AllocateLarge() actually allocates for bytes. */
+size_t LargeSize( const size_t bytes, const bool huge );
+
+const char* PageKindName( const PageKind kind );
+
+#endif /* HUGE_PAGES_H_ */
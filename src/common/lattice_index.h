@@ -0,0 +1,156 @@
+/*
+ * lattice_index.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Directory of partitions keyed by their lattice bitmap. Since only
+ *  partitions whose bitmaps are subsets of a tuple's bitmap can contain
+ *  points that dominate it, the index enumerates just those partitions
+ *  that exist, rather than testing every partition for skippability.
+ *
+ *  For small dimensionality, the directory is a dense table of all 2^d
+ *  bitmaps; otherwise, it is a binary trie over the bits of the
+ *  bitmaps, so that memory is proportional to the inserted bitmaps.
+ */
+
+#ifndef LATTICE_INDEX_H_
+#define LATTICE_INDEX_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+/* Largest dimensionality for which a dense table is used. */
+#define LATTICE_DENSE_MAX_DIMS 16
+
+/* Value of bitmaps that are absent from the index. */
+#define LATTICE_NONE 0xFFFFFFFF
+
+class LatticeIndex {
+public:
+  LatticeIndex( const uint32_t dims ) :
+      dims_( dims ), dense_( dims <= LATTICE_DENSE_MAX_DIMS ), size_( 0 ) {
+    if ( dense_ )
+      table_.assign( 1u << dims, LATTICE_NONE );
+    Clear();
+  }
+
+  /* Removes all bitmaps from the index. */
+  void Clear() {
+    if ( dense_ ) {
+      for (uint32_t i = 0; i < used_.size(); ++i)
+        table_[used_[i]] = LATTICE_NONE;
+      used_.clear();
+    } else {
+      trie_.clear();
+      trie_.push_back( TrieNode() ); // root
+    }
+    size_ = 0;
+  }
+
+  /* Maps bitmap to value. A bitmap must be inserted at most once. */
+  void Insert( const uint32_t bitmap, const uint32_t value ) {
+    ++size_;
+    if ( dense_ ) {
+      table_[bitmap] = value;
+      used_.push_back( bitmap );
+      return;
+    }
+
+    /* Walk the trie from the most significant bit, adding nodes as needed. */
+    uint32_t node = 0;
+    for (int32_t b = dims_ - 1; b >= 0; --b) {
+      const uint32_t bit = (bitmap >> b) & 1;
+      if ( trie_[node].child[bit] == LATTICE_NONE ) {
+        trie_[node].child[bit] = trie_.size();
+        trie_.push_back( TrieNode() );
+      }
+      node = trie_[node].child[bit];
+    }
+    trie_[node].value = value;
+  }
+
+  /* The number of bitmaps in the index. */
+  inline uint32_t size() const {
+    return size_;
+  }
+
+  /* An upper bound on the work of ForEachSubset( mask, ... ). */
+  inline uint32_t SubsetCost( const uint32_t mask ) const {
+    const uint32_t k = __builtin_popcount( mask );
+    return k >= 31 ? LATTICE_NONE : 1u << k;
+  }
+
+  /*
+   * Calls visit( value ) for the value of every inserted bitmap that is a
+   * subset of mask, in ascending order of bitmap, until visit returns true.
+   * Returns true iff some call to visit returned true.
+   */
+  template<typename Visitor>
+  bool ForEachSubset( const uint32_t mask, Visitor &visit ) const;
+
+private:
+  typedef struct TrieNode {
+    uint32_t child[2];
+    uint32_t value;
+    TrieNode() :
+        value( LATTICE_NONE ) {
+      child[0] = child[1] = LATTICE_NONE;
+    }
+  } TrieNode;
+
+  const uint32_t dims_;
+  const bool dense_;
+  uint32_t size_;
+  std::vector<uint32_t> table_; /**< Dense: value per bitmap */
+  std::vector<uint32_t> used_; /**< Dense: inserted bitmaps, for Clear() */
+  std::vector<TrieNode> trie_; /**< Sparse: trie nodes, root first */
+};
+
+// Templated member function has to be defined in a header file..
+
+template<typename Visitor>
+bool LatticeIndex::ForEachSubset( const uint32_t mask, Visitor &visit ) const {
+  if ( dense_ ) {
+    /* Enumerate submasks of mask in ascending order. */
+    uint32_t s = 0;
+    do {
+      const uint32_t v = table_[s];
+      if ( v != LATTICE_NONE && visit( v ) )
+        return true;
+      s = (s - mask) & mask;
+    } while ( s != 0 );
+    return false;
+  }
+
+  /* Depth-first traversal of the trie, descending only into 1-children
+   * where mask has a set bit and visiting 0-children first. */
+  uint32_t stack_node[33];
+  int32_t stack_bit[33];
+  uint32_t top = 0;
+  stack_node[top] = 0;
+  stack_bit[top++] = dims_ - 1;
+  while ( top > 0 ) {
+    --top;
+    const uint32_t node = stack_node[top];
+    const int32_t b = stack_bit[top];
+    if ( b < 0 ) {
+      if ( visit( trie_[node].value ) )
+        return true;
+      continue;
+    }
+    const uint32_t one = trie_[node].child[1];
+    if ( ((mask >> b) & 1) && one != LATTICE_NONE ) {
+      stack_node[top] = one;
+      stack_bit[top++] = b - 1;
+    }
+    const uint32_t zero = trie_[node].child[0];
+    if ( zero != LATTICE_NONE ) {
+      stack_node[top] = zero;
+      stack_bit[top++] = b - 1;
+    }
+  }
+  return false;
+}
+
+#endif /* LATTICE_INDEX_H_ */
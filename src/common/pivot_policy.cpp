@@ -0,0 +1,38 @@
+/*
+ * pivot_policy.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "common/pivot_policy.h"
+
+#include <cstring>
+
+bool ParsePivotPolicy( const char *name, uint32_t *policy ) {
+  for (uint32_t p = PIVOT_RANDOM; p <= PIVOT_VOLUME; ++p) {
+    if ( strcmp( name, PivotPolicyName( p ) ) == 0 ) {
+      *policy = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* PivotPolicyName( const uint32_t policy ) {
+  switch ( policy ) {
+  case PIVOT_RANDOM:
+    return "random";
+  case PIVOT_MEDIAN:
+    return "median";
+  case PIVOT_BALANCED:
+    return "balanced";
+  case PIVOT_BALSKY:
+    return "balsky";
+  case PIVOT_MANHATTAN:
+    return "manhattan";
+  case PIVOT_VOLUME:
+    return "volume";
+  default:
+    return "unknown";
+  }
+}
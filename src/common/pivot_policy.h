@@ -0,0 +1,84 @@
+/*
+ * pivot_policy.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  The pivot selection policies (PIVOT_* in common.h), shared by all
+ *  partitioning algorithms. A point-based policy ranks candidate points
+ *  by a cost over their values normalised to the region that is being
+ *  partitioned. PIVOT_MEDIAN is a virtual point; algorithms that need a
+ *  data point as pivot take the one closest to the centre instead.
+ */
+
+#ifndef PIVOT_POLICY_H_
+#define PIVOT_POLICY_H_
+
+#include <stdint.h>
+
+#include "common/common.h"
+
+/*
+ * Parses a policy name ("random", "median", "balanced", "balsky",
+ * "manhattan" or "volume") into one of the PIVOT_* constants.
+ * Returns false if the name is unknown.
+ */
+bool ParsePivotPolicy( const char *name, uint32_t *policy );
+
+const char* PivotPolicyName( const uint32_t policy );
+
+/*
+ * Returns the cost of value as a pivot under policy (lower is better),
+ * after normalising it by mins and ranges:
+ *  - PIVOT_BALANCED, PIVOT_BALSKY: the range of the normalised values.
+ *    (Both pick the point of minimum range; PIVOT_BALSKY additionally
+ *    requires it to be a skyline point, which the tree-based algorithms
+ *    always do anyway.)
+ *  - PIVOT_VOLUME: minus the dominance volume, i.e., product of (1 - x).
+ *  - PIVOT_MANHATTAN: the Manhattan norm.
+ *  - PIVOT_MEDIAN: the L-infinity distance to the centre of the region.
+ *  - PIVOT_RANDOM: 0, i.e., all points are equal; the algorithms start
+ *    from a random point instead (see NextRandom()).
+ */
+inline float PivotCost( const uint32_t policy, const float* value,
+    const float* mins, const float* ranges ) {
+  float cost = 0;
+  switch ( policy ) {
+  case PIVOT_BALANCED:
+  case PIVOT_BALSKY: {
+    float lo, hi;
+    lo = hi = (value[0] - mins[0]) / ranges[0];
+    for (uint32_t j = 1; j < NUM_DIMS; j++) {
+      const float v_norm = (value[j] - mins[j]) / ranges[j];
+      if ( lo > v_norm )
+        lo = v_norm;
+      else if ( hi < v_norm )
+        hi = v_norm;
+    }
+    cost = hi - lo;
+    break;
+  }
+  case PIVOT_VOLUME:
+    cost = -1;
+    for (uint32_t j = 0; j < NUM_DIMS; j++)
+      cost *= 1 - (value[j] - mins[j]) / ranges[j];
+    break;
+  case PIVOT_MANHATTAN:
+    for (uint32_t j = 0; j < NUM_DIMS; j++)
+      cost += (value[j] - mins[j]) / ranges[j];
+    break;
+  case PIVOT_MEDIAN:
+    for (uint32_t j = 0; j < NUM_DIMS; j++) {
+      const float off = (value[j] - mins[j]) / ranges[j] - 0.5f;
+      if ( off > cost )
+        cost = off;
+      else if ( -off > cost )
+        cost = -off;
+    }
+    break;
+  default: // PIVOT_RANDOM
+    break;
+  }
+  return cost;
+}
+
+#endif /* PIVOT_POLICY_H_ */
@@ -11,6 +11,7 @@
 #ifndef PQ_FILTER_H_
 #define PQ_FILTER_H_
 
+#include <cmath>
 #include <queue>
 #include <vector>
 
@@ -29,7 +30,7 @@
 
 using namespace std;
 
-typedef std::pair<uint32_t, float> mn_w_idx;
+typedef std::pair<TupleIdx, float> mn_w_idx;
 
 struct PQComparator {
   bool operator()( const mn_w_idx &a, const mn_w_idx &b ) {
@@ -46,84 +47,287 @@ public:
    * Executes priority queue based filtering on data using num_threads
    * queues each of pq_size.
    *
+   * Each queue keeps the pq_size points of its thread's share with the
+   * greatest dominance volume (product of normalised complements, 1 - x),
+   * which estimates how much of the data space a point prunes. Duplicate
+   * pruners and pruners dominated by other pruners are then dropped, and
+   * all points are tested against the remaining ones, stored by column.
+   *
    * Side affect: simultaneously computes Manhattan norm in TUPLE.score.
    */
   template<typename T>
-  static uint32_t Execute( T* data, const uint32_t n,
+  static TupleIdx Execute( T* data, const TupleIdx n,
+      const uint32_t pq_size, const uint32_t num_threads );
+
+  /*
+   * As above, but filters the indices idx[0...n-1] into the read-only
+   * tuples data, rather than the tuples themselves: the indices of the
+   * survivors are left at the front of idx (in the order in which the
+   * above would leave the tuples). Computes no scores.
+   */
+  static TupleIdx Execute( const TUPLE* data, TupleIdx* idx,
+      const TupleIdx n, const uint32_t pq_size, const uint32_t num_threads );
+
+private:
+  /* The tuples data[0...n-1], filtered in place. */
+  template<typename T>
+  struct TupleArray {
+    T* const data;
+    inline const TUPLE& Get( const TupleIdx i ) const {
+      return data[i];
+    }
+    inline void SetScore( const TupleIdx i, const float score ) const {
+      data[i].score = score;
+    }
+    inline void MarkPruned( const TupleIdx i ) const {
+      data[i].markPruned();
+    }
+    inline bool IsPruned( const TupleIdx i ) const {
+      return data[i].isPruned();
+    }
+    inline void Move( const TupleIdx to, const TupleIdx from ) const {
+      data[to] = data[from];
+    }
+  };
+
+  /* The tuples data[idx[0]], ..., data[idx[n-1]], filtered by index; a
+   * pruned tuple's index is overwritten with NONE. */
+  struct IndexArray {
+    static const TupleIdx NONE = ~(TupleIdx) 0;
+    const TUPLE* const data;
+    TupleIdx* const idx;
+    inline const TUPLE& Get( const TupleIdx i ) const {
+      return data[idx[i]];
+    }
+    inline void SetScore( const TupleIdx, const float ) const {
+    }
+    inline void MarkPruned( const TupleIdx i ) const {
+      idx[i] = NONE;
+    }
+    inline bool IsPruned( const TupleIdx i ) const {
+      return idx[i] == NONE;
+    }
+    inline void Move( const TupleIdx to, const TupleIdx from ) const {
+      idx[to] = idx[from];
+    }
+  };
+
+  template<typename A>
+  static TupleIdx Filter( const A &tuples, const TupleIdx n,
       const uint32_t pq_size, const uint32_t num_threads );
 
+  static float Volume( const TUPLE &t, const float* mins,
+      const float* inv_ranges );
+
+  template<typename A>
+  static vector<TupleIdx> SelectPruners( const A &tuples,
+      vector<TupleIdx> &candidates );
+
+  static inline bool IsPrunedBy( const float* cols, const uint32_t stride,
+      const float* value );
 };
 
 // Templated static function has to be defined in a header file..
 
+/*
+ * Dominance volume of t, relative to the bounding box given by mins and
+ * inverse ranges. (Dimensions of zero range have an inverse range of 0.)
+ */
+inline float PQFilter::Volume( const TUPLE &t, const float* mins,
+    const float* inv_ranges ) {
+  float volume = 1;
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    volume *= 1 - (t.elems[j] - mins[j]) * inv_ranges[j];
+  }
+  return volume;
+}
+
+/*
+ * Removes duplicates from the candidate pruners and any candidate that
+ * is dominated by another one (its region is contained in the other's).
+ */
+template<typename A>
+vector<TupleIdx> PQFilter::SelectPruners( const A &tuples,
+    vector<TupleIdx> &candidates ) {
+  std::sort( candidates.begin(), candidates.end() );
+  candidates.erase( std::unique( candidates.begin(), candidates.end() ),
+      candidates.end() );
+
+  vector<TupleIdx> pruners;
+  pruners.reserve( candidates.size() );
+  for (uint32_t i = 0; i < candidates.size(); ++i) {
+    bool dominated = false;
+    for (uint32_t j = 0; j < candidates.size() && !dominated; ++j) {
+      dominated = DominateLeft( tuples.Get( candidates[j] ),
+          tuples.Get( candidates[i] ) );
+    }
+    if ( !dominated )
+      pruners.push_back( candidates[i] );
+  }
+  return pruners;
+}
+
+/*
+ * Tests value against all pruners, stored column-wise in cols: column j
+ * starts at cols + j * stride, and stride is a multiple of 8, padded with
+ * +inf values (which dominate nothing). Returns true iff some pruner
+ * dominates value.
+ */
+inline bool PQFilter::IsPrunedBy( const float* cols, const uint32_t stride,
+    const float* value ) {
+#if __AVX__
+  for (uint32_t b = 0; b < stride; b += 8) {
+#if COUNT_DT==1
+    __sync_fetch_and_add( &dt_count, 8 );
+#endif
+    __m256 le = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+    __m256 lt = _mm256_setzero_ps();
+    uint32_t j;
+    for (j = 0; j < NUM_DIMS; ++j) {
+      const __m256 p_ymm = _mm256_loadu_ps( cols + j * stride + b );
+      const __m256 v_ymm = _mm256_set1_ps( value[j] );
+      le = _mm256_and_ps( le, _mm256_cmp_ps( p_ymm, v_ymm, _CMP_LE_OQ ) );
+      lt = _mm256_or_ps( lt, _mm256_cmp_ps( p_ymm, v_ymm, _CMP_LT_OQ ) );
+      if ( _mm256_testz_ps( le, le ) )
+        break;
+    }
+    if ( j == NUM_DIMS && _mm256_movemask_ps( _mm256_and_ps( le, lt ) ) )
+      return true;
+  }
+#else
+  for (uint32_t p = 0; p < stride; ++p) {
+#if COUNT_DT==1
+    __sync_fetch_and_add( &dt_count, 1 );
+#endif
+    bool lt = false;
+    uint32_t j;
+    for (j = 0; j < NUM_DIMS && cols[j * stride + p] <= value[j]; ++j) {
+      lt |= cols[j * stride + p] < value[j];
+    }
+    if ( j == NUM_DIMS && lt )
+      return true;
+  }
+#endif
+  return false;
+}
+
 template<typename T>
-uint32_t PQFilter::Execute( T* data, const uint32_t n, const uint32_t pq_size,
+TupleIdx PQFilter::Execute( T* data, const TupleIdx n, const uint32_t pq_size,
     const uint32_t num_threads ) {
+  const TupleArray<T> tuples = { data };
+  return Filter( tuples, n, pq_size, num_threads );
+}
+
+inline TupleIdx PQFilter::Execute( const TUPLE* data, TupleIdx* idx,
+    const TupleIdx n, const uint32_t pq_size, const uint32_t num_threads ) {
+  const IndexArray tuples = { data, idx };
+  return Filter( tuples, n, pq_size, num_threads );
+}
+
+template<typename A>
+TupleIdx PQFilter::Filter( const A &tuples, const TupleIdx n,
+    const uint32_t pq_size, const uint32_t num_threads ) {
   PQ * const PQs_ = new PQ[num_threads];
 
-  /* Init all threads to first q_size points and score them. */
-  for (uint32_t i = 0; i < pq_size; ++i) {
-    data[i].score = 0;
+  /* Compute man norm scores and the bounding box of the data. */
+  float mins[NUM_DIMS], maxs[NUM_DIMS], inv_ranges[NUM_DIMS];
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    mins[j] = maxs[j] = tuples.Get( 0 ).elems[j];
+  }
+#pragma omp parallel num_threads(num_threads)
+  {
+    float th_mins[NUM_DIMS], th_maxs[NUM_DIMS];
     for (uint32_t j = 0; j < NUM_DIMS; ++j) {
-      data[i].score += data[i].elems[j];
+      th_mins[j] = th_maxs[j] = tuples.Get( 0 ).elems[j];
     }
+#pragma omp for nowait
+    for (TupleIdx i = 0; i < n; ++i) {
+      const TUPLE &t = tuples.Get( i );
+      float sum = 0;
+      for (uint32_t j = 0; j < NUM_DIMS; j++) {
+        sum += t.elems[j];
+        th_mins[j] = std::min( th_mins[j], t.elems[j] );
+        th_maxs[j] = std::max( th_maxs[j], t.elems[j] );
+      }
+      tuples.SetScore( i, sum );
+    } // END PARALLEL FOR
+#pragma omp critical
+    {
+      for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+        mins[j] = std::min( mins[j], th_mins[j] );
+        maxs[j] = std::max( maxs[j], th_maxs[j] );
+      }
+    } // END CRITICAL
+  } // END PARALLEL
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    const float range = maxs[j] - mins[j];
+    inv_ranges[j] = range > 0 ? 1 / range : 0;
+  }
+
+  /* Init all threads to first q_size points. Queues are keyed by negated
+   * volume, so that their tops are the smallest volumes kept. */
+  for (uint32_t i = 0; i < pq_size; ++i) {
+    const float key = -Volume( tuples.Get( i ), mins, inv_ranges );
     for (uint32_t j = 0; j < num_threads; ++j) {
-      PQs_[j].push( mn_w_idx( i, data[i].score ) );
+      PQs_[j].push( mn_w_idx( i, key ) );
     }
   }
 
-  /* Computing top man norm scores and remember best q_size ones. */
+  /* Computing dominance volumes and remember best q_size ones. */
 #pragma omp parallel num_threads(num_threads)
   {
     const uint32_t th_id = omp_get_thread_num();
     mn_w_idx worst_of_bests = PQs_[th_id].top();
 #pragma omp for nowait
-    for (uint32_t i = 0; i < n; ++i) {
-      float sum = 0;
-      for (uint32_t j = 0; j < NUM_DIMS; j++) {
-        sum += data[i].elems[j];
-      }
-      data[i].score = sum;
+    for (TupleIdx i = pq_size; i < n; ++i) {
+      const float key = -Volume( tuples.Get( i ), mins, inv_ranges );
 
-      /* Compare to best found man norms for this thread. */
-      if ( worst_of_bests.second > sum ) {
+      /* Compare to best found volumes for this thread. */
+      if ( worst_of_bests.second > key ) {
         PQs_[th_id].pop();
-        PQs_[th_id].push( mn_w_idx( i, sum ) );
+        PQs_[th_id].push( mn_w_idx( i, key ) );
         worst_of_bests = PQs_[th_id].top();
       }
     }
   } // END PARALLEL FOR
 
   /* Take top pruners and merge them into one set. */
-  vector<uint32_t> pruners;
-  pruners.reserve( num_threads * pq_size );
+  vector<TupleIdx> candidates;
+  candidates.reserve( num_threads * pq_size );
   for (uint32_t i = 0; i < num_threads; ++i) {
     while ( !PQs_[i].empty() ) {
       mn_w_idx top = PQs_[i].top();
-      pruners.push_back( top.first );
+      candidates.push_back( top.first );
       PQs_[i].pop();
     }
   }
+  delete[] PQs_;
+  const vector<TupleIdx> pruners = SelectPruners( tuples, candidates );
+
+  /* Lay the pruners out column-wise, padded to a multiple of 8. */
+  const uint32_t stride = (pruners.size() + 7) & ~7u;
+  vector<float> cols( NUM_DIMS * stride, INFINITY );
+  for (uint32_t p = 0; p < pruners.size(); ++p) {
+    for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+      cols[j * stride + p] = tuples.Get( pruners[p] ).elems[j];
+    }
+  }
 
-  //  UPD_PROFILER( "01 calc mns" );
+  //  UPD_PROFILER( "01 calc volumes" );
 
   /* Pre-filter dataset using top pruners. */
-#pragma omp parallel for
-  for (uint32_t i = 0; i < n; ++i) {
-    for (vector<uint32_t>::iterator it = pruners.begin(); it != pruners.end();
-        ++it) {
-      if ( DominateLeft( data[*it], data[i] ) ) {
-        data[i].markPruned();
-        break;
-      }
+#pragma omp parallel for num_threads(num_threads)
+  for (TupleIdx i = 0; i < n; ++i) {
+    if ( IsPrunedBy( &cols[0], stride, tuples.Get( i ).elems ) ) {
+      tuples.MarkPruned( i );
     }
   } // END PARALLEL FOR
 
   /* Determine how many points were pruned. */
-  uint32_t new_n = n;
-  for (uint32_t i = 0; i < new_n; ++i) {
-    if ( data[i].isPruned() ) {
-      data[i--] = data[--new_n];
+  TupleIdx new_n = n;
+  for (TupleIdx i = 0; i < new_n; ++i) {
+    if ( tuples.IsPruned( i ) ) {
+      tuples.Move( i--, --new_n );
     }
   }
 
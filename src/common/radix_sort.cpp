@@ -0,0 +1,88 @@
+/*
+ * radix_sort.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "common/radix_sort.h"
+
+#include <algorithm>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#define omp_get_num_threads() 1
+#endif
+
+void ParallelRadixSort::Sort( KeyIndex* keys, const TupleIdx n,
+    const uint32_t num_threads, KeyIndex* scratch ) {
+  if ( n < 2 )
+    return;
+
+  /* Find which bytes differ in at least one key. */
+  uint64_t key_or = 0, key_and = ~((uint64_t) 0);
+#pragma omp parallel for num_threads(num_threads) reduction(|:key_or) reduction(&:key_and)
+  for (TupleIdx i = 0; i < n; ++i) {
+    key_or |= keys[i].key;
+    key_and &= keys[i].key;
+  } // END PARALLEL FOR
+  const uint64_t varying = key_or ^ key_and;
+
+  KeyIndex* const tmp = scratch;
+  TupleIdx* const hist = (TupleIdx*) (scratch + n);
+  uint32_t num_passes = 0;
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    const uint32_t nt = omp_get_num_threads();
+    const uint32_t th = omp_get_thread_num();
+    const TupleIdx lo = (uint64_t) n * th / nt;
+    const TupleIdx hi = (uint64_t) n * (th + 1) / nt;
+    TupleIdx* const my_hist = hist + th * RADIX_BUCKETS;
+    TupleIdx offset[RADIX_BUCKETS];
+    KeyIndex* src = keys;
+    KeyIndex* dst = tmp;
+    uint32_t passes = 0;
+
+    for (uint32_t shift = 0; shift < 64; shift += RADIX_BITS) {
+      if ( ((varying >> shift) & (RADIX_BUCKETS - 1)) == 0 )
+        continue;
+
+      /* Histogram of this thread's chunk. */
+      std::fill( my_hist, my_hist + RADIX_BUCKETS, 0 );
+      for (TupleIdx i = lo; i < hi; ++i)
+        ++my_hist[(src[i].key >> shift) & (RADIX_BUCKETS - 1)];
+#pragma omp barrier
+
+      /* Output offsets: all smaller digits, then this digit in
+       * preceding chunks (which keeps the pass stable). */
+      TupleIdx sum = 0;
+      for (uint32_t b = 0; b < RADIX_BUCKETS; ++b) {
+        for (uint32_t t = 0; t < nt; ++t) {
+          if ( t == th )
+            offset[b] = sum;
+          sum += hist[t * RADIX_BUCKETS + b];
+        }
+      }
+
+      /* Scatter this thread's chunk. */
+      for (TupleIdx i = lo; i < hi; ++i)
+        dst[offset[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+#pragma omp barrier
+
+      std::swap( src, dst );
+      ++passes;
+    }
+#pragma omp master
+    num_passes = passes;
+  } // END PARALLEL
+
+  /* After an odd number of passes, the result sits in tmp. */
+  if ( num_passes % 2 == 1 ) {
+#pragma omp parallel for num_threads(num_threads)
+    for (TupleIdx i = 0; i < n; ++i) {
+      keys[i] = tmp[i];
+    } // END PARALLEL FOR
+  }
+}
@@ -0,0 +1,82 @@
+/*
+ * radix_sort.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Parallel LSD radix sort over compact (64-bit key, tuple index)
+ *  pairs. Rather than sorting wide tuples with a branchy comparator,
+ *  the algorithms pack their sort order into a key, sort the pairs,
+ *  and then permute the tuples once.
+ */
+
+#ifndef RADIX_SORT_H_
+#define RADIX_SORT_H_
+
+#include <stdint.h>
+#include <cstring>
+
+#include "common/common.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+typedef struct KeyIndex {
+  uint64_t key;
+  TupleIdx idx;
+} KeyIndex;
+
+/*
+ * Maps a float onto an unsigned integer with the same order, so that
+ * scores can be packed into the low bits of a radix key.
+ */
+inline uint32_t FloatToKey( const float f ) {
+  uint32_t u;
+  memcpy( &u, &f, sizeof(float) );
+  return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+class ParallelRadixSort {
+public:
+  /*
+   * Stably sorts keys[0...n-1] by ascending key using num_threads.
+   * Passes over bytes that are identical in all keys are skipped, so
+   * short keys (e.g., a single float) only cost as many passes as
+   * they have varying bytes.
+   *
+   * scratch must hold ScratchSize( n, num_threads ) KeyIndex's; it is
+   * provided by the caller so that it can be reused across runs (see
+   * Arena).
+   */
+  static void Sort( KeyIndex* keys, const TupleIdx n,
+      const uint32_t num_threads, KeyIndex* scratch );
+
+  /*
+   * Number of KeyIndex's of scratch space that Sort() needs: a buffer for
+   * the keys, followed by the per-thread histograms.
+   */
+  static inline size_t ScratchSize( const TupleIdx n,
+      const uint32_t num_threads ) {
+    return n + (sizeof(TupleIdx) * num_threads * RADIX_BUCKETS
+        + sizeof(KeyIndex) - 1) / sizeof(KeyIndex);
+  }
+
+  /*
+   * Gathers dst[i] = src[keys[i].idx] for all i < n in parallel.
+   */
+  template<typename T>
+  static void Permute( const T* src, T* dst, const KeyIndex* keys,
+      const TupleIdx n, const uint32_t num_threads );
+};
+
+// Templated static function has to be defined in a header file..
+
+template<typename T>
+void ParallelRadixSort::Permute( const T* src, T* dst, const KeyIndex* keys,
+    const TupleIdx n, const uint32_t num_threads ) {
+#pragma omp parallel for num_threads(num_threads)
+  for (TupleIdx i = 0; i < n; ++i) {
+    dst[i] = src[keys[i].idx];
+  } // END PARALLEL FOR
+}
+
+#endif /* RADIX_SORT_H_ */
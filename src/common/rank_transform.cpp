@@ -0,0 +1,71 @@
+/*
+ * rank_transform.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "common/rank_transform.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#define omp_get_num_threads() 1
+#endif
+
+#include "common/radix_sort.h"
+
+uint32_t RankTransform::Execute( float** data, const TupleIdx n,
+    const uint32_t num_threads, uint32_t* ranks, Arena* arena ) {
+  KeyIndex* keys = AllocateIn<KeyIndex>( arena, n );
+  KeyIndex* scratch = AllocateIn<KeyIndex>( arena,
+      ParallelRadixSort::ScratchSize( n, num_threads ) );
+  TupleIdx* counts = AllocateIn<TupleIdx>( arena, num_threads );
+  uint32_t max_distinct = 0;
+
+  for (uint32_t j = 0; j < NUM_DIMS; ++j) {
+    /* Sort the column (adding +0 maps -0 onto +0). */
+#pragma omp parallel for num_threads(num_threads)
+    for (TupleIdx i = 0; i < n; ++i) {
+      keys[i].key = FloatToKey( data[i][j] + 0.0f );
+      keys[i].idx = i;
+    } // END PARALLEL FOR
+    ParallelRadixSort::Sort( keys, n, num_threads, scratch );
+
+    /* The rank of keys[i] is the number of distinct keys before it: each
+     * thread counts the new keys in its chunk, then ranks from the sum
+     * of the counts of the chunks before it. */
+#pragma omp parallel num_threads(num_threads)
+    {
+      const uint32_t nt = omp_get_num_threads();
+      const uint32_t th = omp_get_thread_num();
+      const TupleIdx lo = (uint64_t) n * th / nt;
+      const TupleIdx hi = (uint64_t) n * (th + 1) / nt;
+      TupleIdx cnt = 0;
+      for (TupleIdx i = lo; i < hi; ++i) {
+        if ( i > 0 && keys[i].key != keys[i - 1].key )
+          ++cnt;
+      }
+      counts[th] = cnt;
+#pragma omp barrier
+
+      TupleIdx rank = 0;
+      for (uint32_t t = 0; t < th; ++t)
+        rank += counts[t];
+      for (TupleIdx i = lo; i < hi; ++i) {
+        if ( i > 0 && keys[i].key != keys[i - 1].key )
+          ++rank;
+        ranks[(size_t) keys[i].idx * NUM_DIMS + j] = rank;
+      }
+    } // END PARALLEL
+
+    if ( n > 0 )
+      max_distinct = std::max( max_distinct,
+          ranks[(size_t) keys[n - 1].idx * NUM_DIMS + j] + 1 );
+  }
+
+  ReleaseIn( arena, keys );
+  ReleaseIn( arena, scratch );
+  ReleaseIn( arena, counts );
+  return max_distinct;
+}
@@ -0,0 +1,51 @@
+/*
+ * rank_transform.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Dense ranking of the columns of a dataset. Dominance only depends on
+ *  the order of the values in each dimension, so a tuple can be replaced
+ *  by the ranks of its values: if no column has more than 2^8 (resp.
+ *  2^16) distinct values, every rank fits a uint8_t (resp. uint16_t) and
+ *  the tuple shrinks 4x (resp. 2x). See dt_codes.h.
+ */
+
+#ifndef RANK_TRANSFORM_H_
+#define RANK_TRANSFORM_H_
+
+#include <stdint.h>
+
+#include "common/arena.h"
+#include "common/dt_codes.h"
+
+class RankTransform {
+public:
+
+  /*
+   * Computes the dense rank (0 for the smallest value) of every value of
+   * data, n rows of NUM_DIMS values, into ranks[i * NUM_DIMS + j] (of 
+   * n * NUM_DIMS values), using num_threads threads. Equal values 
+   * (including -0 and +0) get equal ranks. The temporary buffers are
+   * taken from arena (see AllocateIn()).
+   *
+   * Returns the largest number of distinct values in any column.
+   */
+  static uint32_t Execute( float** data, const TupleIdx n,
+      const uint32_t num_threads, uint32_t* ranks, Arena* arena );
+
+  /*
+   * Sets t to the codes of row pid of ranks (as computed by Execute()),
+   * which must all fit in C.
+   */
+  template<typename C>
+  static inline void Encode( const uint32_t* ranks, const TupleId pid,
+      CTUPLE<C> &t ) {
+    for (uint32_t j = 0; j < NUM_DIMS; ++j)
+      t.codes[j] = ranks[(size_t) pid * NUM_DIMS + j];
+    for (uint32_t j = NUM_DIMS; j < CTUPLE<C>::PADDED; ++j)
+      t.codes[j] = 0;
+    t.pid = pid;
+  }
+};
+
+#endif /* RANK_TRANSFORM_H_ */
@@ -0,0 +1,33 @@
+/*
+ * shared_dataset.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "common/shared_dataset.h"
+
+SharedDataset::SharedDataset( const vector<vector<float> > &vvf,
+    const uint32_t num_threads, const bool huge ) :
+    n_( vvf.size() ) {
+  tuples_ = (TUPLE*) AllocateLarge( sizeof(TUPLE) * (n_ > 0 ? n_ : 1), huge,
+      pages_ );
+  rows_ = new float*[n_];
+
+  /* Fill in parallel, so that the pages are spread over the threads. */
+#pragma omp parallel for num_threads(num_threads)
+  for (TupleIdx i = 0; i < n_; ++i) {
+    const vector<float> &row = vvf[i];
+    const uint32_t d = row.size() < NUM_DIMS ? row.size() : NUM_DIMS;
+    for (uint32_t j = 0; j < d; ++j)
+      tuples_[i].elems[j] = row[j];
+    for (uint32_t j = d; j < NUM_DIMS; ++j)
+      tuples_[i].elems[j] = 0;
+    tuples_[i].pid = i;
+    rows_[i] = tuples_[i].elems;
+  } // END PARALLEL FOR
+}
+
+SharedDataset::~SharedDataset() {
+  FreeLarge( tuples_, sizeof(TUPLE) * (n_ > 0 ? n_ : 1), pages_ );
+  delete[] rows_;
+}
@@ -0,0 +1,63 @@
+/*
+ * shared_dataset.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  An input dataset that is laid out once and then shared, read-only, by
+ *  all the runs of the benchmark: one contiguous, cache-line aligned array
+ *  of TUPLEs, the i'th of which has pid i, plus a view of their values as
+ *  float** rows (for Init() and the filters). The tuples can be backed by
+ *  huge pages (see huge_pages.h).
+ */
+
+#ifndef SHARED_DATASET_H_
+#define SHARED_DATASET_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "common/common.h"
+#include "common/huge_pages.h"
+
+using namespace std;
+
+class SharedDataset {
+public:
+
+  /*
+   * Lays out the rows of vvf (of which the first NUM_DIMS values are
+   * used, and missing ones are 0), using num_threads threads, on huge
+   * pages where available if huge.
+   */
+  SharedDataset( const vector<vector<float> > &vvf,
+      const uint32_t num_threads, const bool huge = false );
+  ~SharedDataset();
+
+  inline TupleIdx size() const {
+    return n_;
+  }
+  inline const TUPLE* tuples() const {
+    return tuples_;
+  }
+  inline float** rows() const {
+    return rows_;
+  }
+  inline PageKind pages() const {
+    return pages_;
+  }
+  inline size_t huge_bytes() const {
+    return HugeBytes( tuples_, sizeof(TUPLE) * (n_ > 0 ? n_ : 1), pages_ );
+  }
+
+private:
+  SharedDataset( const SharedDataset& );
+  SharedDataset& operator=( const SharedDataset& );
+
+  const TupleIdx n_;
+  TUPLE* tuples_; // n_ tuples, aligned to a cache line
+  float** rows_; // rows_[i] = tuples_[i].elems
+  PageKind pages_; // backing of tuples_
+};
+
+#endif /* SHARED_DATASET_H_ */
@@ -7,6 +7,11 @@
 
 #include <cstdio>
 #include "common/skyline_i.h"
+#include "common/shared_dataset.h"
+
+void SkylineI::InitShared( const SharedDataset &data ) {
+  Init( data.rows() );
+}
 
 /* Profiling stuff (for breakdown charts). */
 #if PROFILER == 1
@@ -17,6 +17,9 @@
 #include <map>
 #include <sys/time.h>
 
+#include "common/arena.h"
+#include "common/common.h"
+
 // Use these MACROS to gather run-times at different
 // algorithm stages (instead of function calls as MACROS
 // are easy disabled with DPROFILER=0 during compilation).
@@ -30,14 +33,24 @@
   #define PRI_PROFILER() ((void)0)
 #endif
 
+class SharedDataset;
+
 class SkylineI {
 public:
-  SkylineI() { }
+  SkylineI() : arena_( NULL ) { }
   virtual ~SkylineI() { }
 
   /* Pure virtual methods */
   virtual void Init(float** data) = 0;
-  virtual std::vector<int> Execute() = 0;
+  virtual std::vector<TupleId> Execute() = 0;
+
+  /* Initializes from a dataset shared, read-only, by all runs (instead of
+   * from a private copy of it). By default, the same as Init( rows ). */
+  virtual void InitShared(const SharedDataset &data);
+
+  /* Sets the arena from which the per-run buffers are taken (NULL for the
+   * heap). It must not be reset before this algorithm is deleted. */
+  void SetArena(Arena* arena) { arena_ = arena; }
 
   /* Profiling stuff (for breakdown charts). */
 #if PROFILER == 1
@@ -49,6 +62,20 @@ public:
   void printProfile();
   void updateProfiler(std::string map_key);
 #endif
+
+protected:
+  /* Per-run buffer of n (uninitialised) T's: from the arena, if set, and
+   * otherwise from the heap. Release with FreeBuffer(). */
+  template<typename T>
+  T* AllocBuffer(const size_t n) {
+    return AllocateIn<T>( arena_, n );
+  }
+  template<typename T>
+  void FreeBuffer(T* buffer) {
+    ReleaseIn( arena_, buffer );
+  }
+
+  Arena* arena_;
 };
 
 #endif /* SKYLINE_I_H_ */
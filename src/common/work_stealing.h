@@ -0,0 +1,172 @@
+/*
+ * work_stealing.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Work-stealing loop scheduler for the teams of an OpenMP parallel
+ *  region. Each worker starts with an equal, contiguous range of the
+ *  iteration space and takes small chunks from its front; a worker whose
+ *  range is empty steals the back half of another worker's range. Unlike
+ *  a fixed static or dynamic schedule, this balances loops in which the
+ *  cost per iteration varies by orders of magnitude (e.g., a tuple that is
+ *  pruned by the first partition versus one that scans the whole skyline),
+ *  while keeping the common case contention-free. Since it runs inside
+ *  the caller's team, all algorithms share the one OpenMP thread pool.
+ */
+
+#ifndef WORK_STEALING_H_
+#define WORK_STEALING_H_
+
+#include <stdint.h>
+#include <sched.h>
+
+#include <cassert>
+
+#include "common/common.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#define omp_get_num_threads() 1
+#endif
+
+/* Default number of iterations that a worker takes from its range at once. */
+#define WS_DEFAULT_GRAIN 8
+
+/* Longest range that is scheduled at once; see ForEach(). */
+#define WS_MAX_WINDOW 0xFFFFFFFFu
+
+class WorkStealingScheduler {
+public:
+  WorkStealingScheduler( const uint32_t max_threads ) :
+      max_threads_( max_threads ), remaining_( 0 ) {
+    slots_ = new Slot[max_threads];
+  }
+
+  ~WorkStealingScheduler() {
+    delete[] slots_;
+  }
+
+  /*
+   * Calls body( i ) exactly once for every i in [begin, end), taking
+   * chunks of at most grain iterations at a time. The ranges are kept
+   * relative to their start in 32 bits, so a longer loop (only possible
+   * with 64-bit tuple ids) is run as a sequence of windows of at most
+   * WS_MAX_WINDOW iterations each.
+   *
+   * Must be called by every thread of the enclosing parallel region with
+   * the same arguments (or outside of any parallel region, in which case
+   * it runs sequentially). Ends with a barrier.
+   */
+  template<typename Body>
+  void ForEach( const TupleIdx begin, const TupleIdx end,
+      const uint32_t grain, Body &body );
+
+private:
+  /* Schedules the n iterations [begin, begin + n). Ends with a barrier. */
+  template<typename Body>
+  void ForEachWindow( const TupleIdx begin, const uint32_t n,
+      const uint32_t grain, Body &body );
+
+  /* A worker's remaining range, packed as (lo << 32 | hi) so that it can
+   * be updated by a single compare-and-swap; padded to a cache line. */
+  typedef struct Slot {
+    volatile uint64_t range;
+    char pad[64 - sizeof(uint64_t)];
+  } Slot;
+
+  static inline uint64_t Pack( const uint32_t lo, const uint32_t hi ) {
+    return ((uint64_t) lo << 32) | hi;
+  }
+
+  /* Takes up to grain iterations from the front of slot s. */
+  inline bool TakeFront( Slot &s, const uint32_t grain, uint32_t &lo,
+      uint32_t &hi ) {
+    for (;;) {
+      const uint64_t old = s.range;
+      lo = old >> 32;
+      const uint32_t top = (uint32_t) old;
+      if ( lo >= top )
+        return false;
+      hi = top - lo > grain ? lo + grain : top;
+      if ( __sync_bool_compare_and_swap( &s.range, old, Pack( hi, top ) ) )
+        return true;
+    }
+  }
+
+  /* Moves the back half of slot victim into (the empty) slot thief. */
+  inline bool StealHalf( Slot &victim, Slot &thief ) {
+    for (;;) {
+      const uint64_t old = victim.range;
+      const uint32_t lo = old >> 32, hi = (uint32_t) old;
+      if ( lo >= hi )
+        return false;
+      const uint32_t mid = lo + (hi - lo) / 2;
+      if ( __sync_bool_compare_and_swap( &victim.range, old,
+          Pack( lo, mid ) ) ) {
+        thief.range = Pack( mid, hi );
+        return true;
+      }
+    }
+  }
+
+  const uint32_t max_threads_;
+  Slot* slots_;
+  volatile uint64_t remaining_; /**< Iterations not yet executed */
+};
+
+// Templated member function has to be defined in a header file..
+
+template<typename Body>
+void WorkStealingScheduler::ForEach( const TupleIdx begin, const TupleIdx end,
+    const uint32_t grain, Body &body ) {
+  if ( end <= begin ) {
+    ForEachWindow( begin, 0, grain, body ); // keep the barriers
+    return;
+  }
+  for (TupleIdx lo = begin; lo < end;) {
+    const TupleIdx n = end - lo < WS_MAX_WINDOW ? end - lo : WS_MAX_WINDOW;
+    ForEachWindow( lo, (uint32_t) n, grain, body );
+    lo += n;
+  }
+}
+
+template<typename Body>
+void WorkStealingScheduler::ForEachWindow( const TupleIdx begin,
+    const uint32_t n, const uint32_t grain, Body &body ) {
+  const uint32_t nt = omp_get_num_threads();
+  const uint32_t th = omp_get_thread_num();
+  assert( nt <= max_threads_ );
+
+  /* Every worker starts with its share of the iteration space. */
+  slots_[th].range = Pack( (uint64_t) n * th / nt,
+      (uint64_t) n * (th + 1) / nt );
+  if ( th == 0 )
+    remaining_ = n;
+#pragma omp barrier
+
+  uint32_t victim = th;
+  while ( remaining_ > 0 ) {
+    uint32_t lo, hi;
+    if ( TakeFront( slots_[th], grain, lo, hi ) ) {
+      for (uint32_t i = lo; i < hi; ++i)
+        body( begin + i );
+      __sync_fetch_and_sub( &remaining_, (uint64_t) (hi - lo) );
+      continue;
+    }
+
+    /* Own range is empty: try each other worker once, round robin. */
+    bool stolen = false;
+    for (uint32_t k = 1; k < nt && !stolen; ++k) {
+      victim = victim + 1 < nt ? victim + 1 : 0;
+      if ( victim != th )
+        stolen = StealHalf( slots_[victim], slots_[th] );
+    }
+    if ( !stolen )
+      sched_yield(); // remaining work is in progress elsewhere
+  }
+#pragma omp barrier
+}
+
+#endif /* WORK_STEALING_H_ */
@@ -24,8 +24,18 @@
 #define omp_set_num_threads( t ) 0
 #endif
 
+#include "common/pivot_policy.h"
 #include "common/pq_filter.h"
+#include "common/radix_sort.h"
+#include "common/shared_dataset.h"
+#include "hybrid/sample_filter.h"
 #include "util/timing.h"
+#include "util/topology.h"
+
+/* Orders skyline points by their lattice code within a partition. */
+static inline bool ComparePartitionCode( const EPTUPLE &a, const EPTUPLE &b ) {
+  return a.partition < b.partition;
+}
 
 /**
  * Constructs a new instance of a Hybrid skyline solver.
@@ -36,25 +46,54 @@
  * @param accum The blocksize, alpha, of points to process in each parallel batch.
  * @param pq_size Size of the priority queues to use in the pre-filter (i.e., the
  * maximum number of points that each thread should reserve for pre-pruning).
+ * @param pivot_type The policy by which to select the partitioning pivot: 
+ * PIVOT_MEDIAN (default), PIVOT_BALANCED, PIVOT_BALSKY, PIVOT_VOLUME, 
+ * PIVOT_MANHATTAN, or PIVOT_RANDOM (see select_pivot()).
+ * @param split_size Partitions of skyline points that would be scanned 
+ * linearly over more than this many points are partitioned again.
+ * @param max_depth The maximum number of levels of partitioning.
+ * @param numa Whether to run in NUMA mode, in which each socket compares 
+ * candidates against its own copy of the confirmed skyline points.
+ * @param sample_ratio If positive, the fraction of the input whose skyline 
+ * pre-filters the data (see SampleFilter) before the priority queue filter.
  * @note After instantiating, a Hybrid skyline solver still requires a call to
  * Init() to copy data locally.
  */
-Hybrid::Hybrid( uint32_t threads, uint32_t n, uint32_t d,
-    const uint32_t accum, const uint32_t pq_size ) :
-    num_threads_( threads ), n_( n ), accum_( accum ), pq_size_( pq_size ) {
+Hybrid::Hybrid( uint32_t threads, TupleIdx n, uint32_t d,
+    const uint32_t accum, const uint32_t pq_size, const uint32_t pivot_type,
+    const uint32_t split_size, const uint32_t max_depth, const bool numa,
+    const float sample_ratio ) :
+    num_threads_( threads ), n_( n ), accum_( accum ), pq_size_( pq_size ),
+    pivot_type_( pivot_type ), split_size_( split_size ),
+    max_depth_( max_depth ), numa_( numa ),
+    num_sockets_( numa ? GetNumSockets() : 1 ),
+    sample_ratio_( sample_ratio ), part_index_( NUM_DIMS ),
+    compactor_( threads ), scheduler_( threads ) {
 
   omp_set_num_threads( threads );
   skyline_.reserve( 1024 );
   part_map_.reserve( 1024 );
   data_ = NULL;
+  hot_ = NULL;
+  staging_ = NULL;
+  thread_socket_ = new uint32_t[threads];
 }
 
 /**
  * Destroys a Hybrid skyline solver and deletes the data associated with it.
  */
 Hybrid::~Hybrid() {
-  delete[] data_;
+  FreeBuffer( data_ );
+  FreeBuffer( hot_ );
+  FreeBuffer( staging_ );
+  for (uint32_t s = 0; s < replicas_.size(); ++s)
+    FreeBuffer( replicas_[s] );
+  for (uint32_t s = 0; s < hot_replicas_.size(); ++s)
+    FreeBuffer( hot_replicas_[s] );
+  delete[] thread_socket_;
   part_map_.clear();
+  sub_parts_.clear();
+  part_index_.Clear();
   skyline_.clear();
 }
 
@@ -66,37 +105,147 @@ Hybrid::~Hybrid() {
  * that will be memcopied into this Hybrid skyline solver.
  */
 void Hybrid::Init( float** data ) {
-  data_ = new EPTUPLE[n_];
-  for (uint32_t i = 0; i < n_; i++) {
+  /* Copy in parallel so that pages are first touched by (and therefore 
+   * allocated near) the threads that later process them. */
+  data_ = AllocBuffer<EPTUPLE>( n_ );
+#pragma omp parallel for schedule(static) num_threads(num_threads_)
+  for (TupleIdx i = 0; i < n_; i++) {
     data_[i].pid = i;
     data_[i].partition = 0;
     memcpy( data_[i].elems, data[i], sizeof(float) * NUM_DIMS );
-  }
+  } // END PARALLEL FOR
 
   /* Pre-filter */
   INI_PROFILER();
+  n_ = SampleFilter::Execute<EPTUPLE>( data_, n_, sample_ratio_, num_threads_,
+      arena_ );
   n_ = PQFilter::Execute<EPTUPLE>( data_, n_, pq_size_, num_threads_ );
   UPD_PROFILER( "01 pq-filter" );
 
   partition();
-#if defined(_OPENMP)
-  std::__parallel::sort( data_, data_ + n_ );
-#else
-  std::sort( data_, data_ + n_ );
-#endif
+  sort();
+
+  /* The compactions of Phase I/II stage up to an alpha block. */
+  staging_ = AllocBuffer<EPTUPLE>( accum_ );
+  compactor_.SetBuffer( staging_, accum_ );
+}
+
+/**
+ * Initializes the Hybrid skyline solver from the shared tuples without 
+ * copying them first: the pre-filter, the pivot selection and the 
+ * partitioning work on an index permutation of the tuples, which is then
+ * radix-sorted, so that the working copy is gathered once, in sorted 
+ * order. (The sample filter has to compact a copy, so falls back to 
+ * Init() if enabled.)
+ *
+ * @param data The dataset shared by all runs, whose i'th tuple has pid i.
+ */
+void Hybrid::InitShared( const SharedDataset &data ) {
+  if ( sample_ratio_ > 0 ) {
+    Init( data.rows() );
+    return;
+  }
+
+  const TUPLE* tuples = data.tuples();
+  TupleIdx* idx = AllocBuffer<TupleIdx>( n_ );
+#pragma omp parallel for num_threads(num_threads_)
+  for (TupleIdx i = 0; i < n_; i++) {
+    idx[i] = i;
+  } // END PARALLEL FOR
+
+  /* Pre-filter */
+  INI_PROFILER();
+  n_ = PQFilter::Execute( tuples, idx, n_, pq_size_, num_threads_ );
+  UPD_PROFILER( "01 pq-filter" );
+
+  TUPLE pivot;
+  select_pivot( pivot, tuples, idx );
+  UPD_PROFILER( "02 select pivot" );
+
+  /* Partition and score the tuples into their sort keys (see sort()). */
+  KeyIndex* keys = AllocBuffer<KeyIndex>( n_ );
+#pragma omp parallel for num_threads(num_threads_)
+  for (TupleIdx i = 0; i < n_; i++) {
+    const TUPLE &t = tuples[idx[i]];
+    float score = 0;
+    for (uint32_t j = 0; j < NUM_DIMS; j++) {
+      score += t.elems[j];
+    }
+    const uint32_t p = DT_bitmap( t, pivot ); // encoded as by setPartition()
+    keys[i].key = ((uint64_t) (__builtin_popcount( p ) << NUM_DIMS | p) << 32)
+        | FloatToKey( score );
+    keys[i].idx = idx[i];
+  } // END PARALLEL FOR
+  FreeBuffer( idx );
+  UPD_PROFILER( "03 partition" );
+  KeyIndex* scratch = AllocBuffer<KeyIndex>(
+      ParallelRadixSort::ScratchSize( n_, num_threads_ ) );
+  ParallelRadixSort::Sort( keys, n_, num_threads_, scratch );
+  FreeBuffer( scratch );
+
+  data_ = AllocBuffer<EPTUPLE>( n_ );
+  hot_ = AllocBuffer<HTUPLE>( n_ );
+#pragma omp parallel for num_threads(num_threads_)
+  for (TupleIdx i = 0; i < n_; i++) {
+    (TUPLE&) data_[i] = tuples[keys[i].idx];
+    data_[i].partition = keys[i].key >> 32;
+    data_[i].score = 0;
+    for (uint32_t j = 0; j < NUM_DIMS; j++) {
+      data_[i].score += data_[i].elems[j];
+    }
+    hot_[i].load( data_[i] );
+  } // END PARALLEL FOR
+  FreeBuffer( keys );
+  UPD_PROFILER( "03 partition" );
+
+  staging_ = AllocBuffer<EPTUPLE>( accum_ );
+  compactor_.SetBuffer( staging_, accum_ );
+}
+
+/**
+ * Sorts data_ in its natural order (see EPTUPLE::operator<) with a 
+ * parallel radix sort on packed (partition, score) keys, and then 
+ * permutes the tuples once into a new array, alongside which it lays
+ * out their hot fields.
+ */
+void inline Hybrid::sort() {
+  KeyIndex* keys = AllocBuffer<KeyIndex>( n_ );
+#pragma omp parallel for num_threads(num_threads_)
+  for (TupleIdx i = 0; i < n_; i++) {
+    keys[i].key = ((uint64_t) data_[i].partition << 32)
+        | FloatToKey( data_[i].score );
+    keys[i].idx = i;
+  } // END PARALLEL FOR
+  KeyIndex* scratch = AllocBuffer<KeyIndex>(
+      ParallelRadixSort::ScratchSize( n_, num_threads_ ) );
+  ParallelRadixSort::Sort( keys, n_, num_threads_, scratch );
+  FreeBuffer( scratch );
+
+  EPTUPLE* sorted = AllocBuffer<EPTUPLE>( n_ );
+  ParallelRadixSort::Permute( data_, sorted, keys, n_, num_threads_ );
+  FreeBuffer( keys );
+  FreeBuffer( data_ );
+  data_ = sorted;
+
+  hot_ = AllocBuffer<HTUPLE>( n_ );
+#pragma omp parallel for num_threads(num_threads_)
+  for (TupleIdx i = 0; i < n_; i++) {
+    hot_[i].load( data_[i] );
+  } // END PARALLEL FOR
+  UPD_PROFILER( "03 partition" );
 }
 
 /**
  * Executes the Hybrid skyline solver to produce a skyline 
  * from the data that it has currently stored.
  */
-vector<int> Hybrid::Execute() {
+vector<TupleId> Hybrid::Execute() {
 
   /* Overwrite local dataset with skyline. */
-  const int num_survive = skyline();
+  const TupleIdx num_survive = skyline();
   
   /* Copy skyline into skyline_ result vector. */
-  for (uint32_t i = 0; i < num_survive; ++i) {
+  for (TupleIdx i = 0; i < num_survive; ++i) {
     skyline_.push_back( data_[i].pid );
   }
 
@@ -116,23 +265,29 @@ vector<int> Hybrid::Execute() {
  * which me should be tested.
  * @post The data point me is internally marked as a side-effect if it is 
  * determined to be dominated.
+ * @note Reads the partitions and scores of the block from hot_, so that
+ * only the points that cannot be skipped are loaded from data_.
  */
-void inline Hybrid::compare_to_peers( const uint32_t me, const uint32_t start ) {
+void inline Hybrid::compare_to_peers( const TupleIdx me, const TupleIdx start ) {
 
   /* First, iterate points in partitions below me's, assuming 
    * distinct value condition.
    */
-  uint32_t i, mylev = data_[me].getLevel();
+  const uint32_t mylev = hot_[me].getLevel();
+  TupleIdx i;
   for (i = start; i < me; ++i) {
-    if ( data_[i].isPruned() )
+    if ( hot_[i].isPruned() )
       continue;
-    if ( data_[i].getLevel() == mylev )
+    if ( hot_[i].getLevel() == mylev )
       break;
-    if ( !data_[me].canskip_partition( data_[i].getPartition() ) ) {
+    if ( !hot_[me].canskip_partition( hot_[i].getPartition() ) ) {
       if ( DominateLeftDVC( data_[i], data_[me] ) ) {
         data_[me].markPruned();
+        hot_[me].markPruned();
         return;
       }
+    } else {
+      COUNT_DT_SKIP( 1 );
     }
   }
 
@@ -141,7 +296,7 @@ void inline Hybrid::compare_to_peers( const uint32_t me, const uint32_t start )
    * points that dominate me. Eventually will find my partition
    * (at position me, if not earlier).
    */
-  for (; data_[i].getPartition() < data_[me].getPartition(); ++i)
+  for (; hot_[i].getPartition() < hot_[me].getPartition(); ++i)
     ;
 
   /* Finally, compare to points within same partition, 
@@ -149,60 +304,120 @@ void inline Hybrid::compare_to_peers( const uint32_t me, const uint32_t start )
    * <= to that of i. (equal Man Norm implies equal or 
    * incomparable points, neither of which dominate me).
    */
-  for (; data_[i].score < data_[me].score; ++i) {
+  for (; hot_[i].score < hot_[me].score; ++i) {
     if ( DominateLeftDVC( data_[i], data_[me] ) ) {
       data_[me].markPruned();
+      hot_[me].markPruned();
       return;
     }
   }
 }
 
 /**
- * Compares tuple t to all known skyline points, using the
- * two-level list of as-yet-created partitions.
+ * Compares tuple data_[i] to the known skyline points in the top-level 
+ * partitions part_map_[first...last), descending recursively into the 
+ * nested partitions of each.
  *
+ * Only partitions whose bitmaps are subsets of t's bitmap can contain
+ * points that dominate t. If there are fewer such bitmaps than
+ * partitions to visit, the existing ones are enumerated from 
+ * part_index_; otherwise, the partitions are scanned and skipped 
+ * individually.
+ *
+ * @param i The index in data_ of the tuple to test for dominance.
+ * @param first Index in part_map_ of the first partition to visit.
+ * @param last Index in part_map_ one past the last partition to visit.
+ * @param sky The skyline points (data_ or a replica of its skyline region).
+ * @param sky_hot The hot fields of sky (hot_ or a replica of them).
  * @pre Assumes that t comes from a partition that 
  * has not yet been added to part_maps_; therefore, 
  * distinct value can be assumed.
  */
-void inline Hybrid::compare_to_skyline_points( EPTUPLE &t ) {
+void inline Hybrid::compare_to_skyline_points( const TupleIdx i,
+    const uint32_t first, const uint32_t last, const EPTUPLE* sky,
+    const HTUPLE* sky_hot ) {
+  EPTUPLE &t = data_[i];
+
+  if ( part_index_.SubsetCost( t.getPartition() ) < last - first ) {
+#if COUNT_DT==1
+    for (uint32_t p = first; p < last; ++p)
+      if ( t.canskip_partition( part_map_[p].code ) )
+        COUNT_DT_SKIP( part_map_[p].end - part_map_[p].begin );
+#endif
+    PartitionVisitor visit = { this, t, first, last, sky, sky_hot };
+    if ( part_index_.ForEachSubset( t.getPartition(), visit ) ) {
+      t.markPruned();
+      hot_[i].markPruned();
+    }
+    return;
+  }
 
-  /* Iterate through all partitions. */
-  vector<pair<uint32_t, uint32_t> >::iterator it;
-  for (it = part_map_.begin(); it != part_map_.end() - 1; ++it) {
+  /* Iterate through the requested partitions. */
+  for (uint32_t p = first; p < last; ++p) {
 
     /* If tuple t cannot skip this partition, do work. */
-    if ( !t.canskip_partition( it->first ) ) {
-
-      /* Set boundaries [begin, end) of partition. */
-      const uint32_t begin = it->second;
-      const uint32_t end = (it + 1)->second;
-
-      /* Compare to head/pivot of partition, constructing 
-       * comparison bitmap. Return if it dominates t.
-       */
-      const uint32_t bitmap = DT_bitmap_dvc( t, data_[begin] );
-      if ( bitmap == ALL_ONES && !EqualityTest( t, data_[begin] ) ) {
+    if ( !t.canskip_partition( part_map_[p].code ) ) {
+      if ( compare_to_partition( t, part_map_[p], sky, sky_hot ) ) {
         t.markPruned();
+        hot_[i].markPruned();
         return;
       }
+    } else {
+      COUNT_DT_SKIP( part_map_[p].end - part_map_[p].begin );
+    }
+  }
+}
 
-      /* Iterate rest of partition, looking for a 
-       * point to dominate t, and aborting if found. 
-       * Skips points based on mutual relationship to 
-       * head/pivot of partition. Can skip if t has a clear
-       * bit where point i has one set.
-       */
-      for (uint32_t i = begin + 1; i < end; ++i) {
-        if ( !(~bitmap & data_[i].partition) || !data_[i].partition ) {
-          if ( DominateLeft( data_[i], t ) ) {
-            t.markPruned();
-            return;
-          }
-        }
+/**
+ * Compares tuple t to the skyline points in one (sub-)partition.
+ *
+ * @param t The tuple to test for dominance.
+ * @param node The partition whose points should be compared to t.
+ * @param sky The skyline points (data_ or a replica of its skyline region).
+ * @param sky_hot The hot fields of sky (hot_ or a replica of them).
+ * @return true iff some point in node dominates t.
+ */
+bool Hybrid::compare_to_partition( const EPTUPLE &t, const PartitionNode &node,
+    const EPTUPLE* sky, const HTUPLE* sky_hot ) {
+
+  /* Compare to head/pivot of partition, constructing 
+   * comparison bitmap. Return if it dominates t.
+   */
+  const uint32_t bitmap = DT_bitmap_dvc( t, sky[node.begin] );
+  if ( bitmap == ALL_ONES && !EqualityTest( t, sky[node.begin] ) ) {
+    return true;
+  }
+
+  /* Descend into the sub-partitions that can contain a point
+   * to dominate t. As below, can skip a sub-partition if t has
+   * a clear bit where the sub-partition has one set.
+   */
+  for (uint32_t c = 0; c < node.num_children; ++c) {
+    const PartitionNode &child = sub_parts_[node.first_child + c];
+    if ( !(~bitmap & child.code) ) {
+      if ( compare_to_partition( t, child, sky, sky_hot ) )
+        return true;
+    } else {
+      COUNT_DT_SKIP( child.end - child.begin );
+    }
+  }
+
+  /* Iterate rest of partition, looking for a 
+   * point to dominate t, and aborting if found. 
+   * Skips points based on mutual relationship to 
+   * head/pivot of partition. Can skip if t has a clear
+   * bit where point i has one set.
+   */
+  for (TupleIdx i = node.split_end; i < node.end; ++i) {
+    if ( !(~bitmap & sky_hot[i].partition) ) {
+      if ( DominateLeft( sky[i], t ) ) {
+        return true;
       }
+    } else {
+      COUNT_DT_SKIP( 1 );
     }
   }
+  return false;
 }
 
 /**
@@ -212,20 +427,17 @@ void inline Hybrid::compare_to_skyline_points( EPTUPLE &t ) {
  * @param start The first index of newly added skyline points.
  * @param end One past the last index of newly added skyline points.
  */
-void inline Hybrid::update_partition_map( const uint32_t start, const uint32_t end ) {
-  /* Remove sentinel and recall id, start of last partition. */
-  part_map_.pop_back();
-  uint32_t last_val = part_map_.at( part_map_.size() - 1 ).first;
-  uint32_t part_start = part_map_.at( part_map_.size() - 1 ).second;
+void inline Hybrid::update_partition_map( const TupleIdx start, const TupleIdx end ) {
+  /* The last partition may be continued by the new points. */
+  const uint32_t first_changed = part_map_.size() - 1;
 
   /* Iterate all new points to find partitions. */
-  for (uint32_t i = start; i < end; ++i) {
+  for (TupleIdx i = start; i < end; ++i) {
 
     /* New partition if id doesn't match previous. */
-    if ( data_[i].getPartition() != last_val ) {
-      last_val = data_[i].getPartition();
-      part_start = i;
-      part_map_.push_back( pair<uint32_t, uint32_t>( last_val, i ) );
+    if ( data_[i].getPartition() != part_map_.back().code ) {
+      part_index_.Insert( data_[i].getPartition(), part_map_.size() );
+      part_map_.push_back( PartitionNode( data_[i].getPartition(), i ) );
     }
 
     /* Otherwise, use the first point in partition to further partition
@@ -234,13 +446,90 @@ void inline Hybrid::update_partition_map( const uint32_t start, const uint32_t e
      * partition_level, since it will no longer be used.
      */
     else {
-      const uint32_t bitcode = DT_bitmap_dvc( data_[i], data_[part_start] );
+      const uint32_t bitcode = DT_bitmap_dvc( data_[i],
+          data_[part_map_.back().begin] );
       data_[i].partition = bitcode;
+      part_map_.back().end = i + 1;
+    }
+  }
+
+  /* Partition again any partition that has grown too large. */
+  for (uint32_t p = first_changed; p < part_map_.size(); ++p) {
+    split_partition( part_map_[p], 1 );
+  }
+}
+
+/**
+ * Recursively partitions the points of a partition that would otherwise be 
+ * scanned linearly, if there are more than split_size_ of them. Each 
+ * child gets the points with one lattice code relative to the pivot of 
+ * the partition, and the first of them becomes the pivot of the child.
+ *
+ * Only the last partition keeps growing, so, to amortise the cost, a 
+ * partition that already has children is rebuilt only once its linearly
+ * scanned points outnumber the ones in the children. The children of the
+ * previous build are then abandoned in sub_parts_.
+ *
+ * @param node The partition to split. Must not be an element of sub_parts_,
+ * since sub_parts_ grows during the call.
+ * @param depth The level of node in the partitioning (top level is 1).
+ */
+void Hybrid::split_partition( PartitionNode &node, const uint32_t depth ) {
+  const TupleIdx num_scanned = node.end - node.split_end;
+  const TupleIdx num_split = node.split_end - node.begin - 1;
+  if ( num_scanned <= split_size_ || num_scanned < num_split
+      || depth >= max_depth_ )
+    return;
+
+  /* Re-code the points of previous children relative to this pivot
+   * and group all points by their codes.
+   */
+  const EPTUPLE &pivot = data_[node.begin];
+  for (TupleIdx i = node.begin + 1; i < node.split_end; ++i) {
+    data_[i].partition = DT_bitmap_dvc( data_[i], pivot );
+  }
+  std::stable_sort( data_ + node.begin + 1, data_ + node.end,
+      ComparePartitionCode );
+
+  /* Create one child per code, coding its points relative to its pivot. */
+  const TupleIdx first_child = sub_parts_.size();
+  for (TupleIdx i = node.begin + 1; i < node.end;) {
+    PartitionNode child( data_[i].partition, i );
+    for (child.end = i + 1;
+        child.end < node.end && data_[child.end].partition == child.code;
+        ++child.end) {
+      data_[child.end].partition = DT_bitmap_dvc( data_[child.end], data_[i] );
     }
+    sub_parts_.push_back( child );
+    i = child.end;
   }
+  node.first_child = first_child;
+  node.num_children = sub_parts_.size() - first_child;
+  node.split_end = node.end;
+
+  /* Recurse on each (copy of a) child, since sub_parts_ may reallocate. */
+  for (TupleIdx c = first_child; c < first_child + node.num_children; ++c) {
+    PartitionNode child = sub_parts_[c];
+    split_partition( child, depth + 1 );
+    sub_parts_[c] = child;
+  }
+}
 
-  /* Replace sentinel at end. */
-  part_map_.push_back( pair<uint32_t, uint32_t>( 0, end + 1 ) );
+/**
+ * Processes the j'th tuple of the combined Phase II/Phase I iteration
+ * space of one round of skyline().
+ */
+void inline Hybrid::BlockTask::operator()( const TupleIdx j ) const {
+  const TupleIdx num_cand = cur_stop - cur_start;
+  if ( j < num_cand ) {
+    const TupleIdx i = cur_start + j;
+    owner->compare_to_skyline_points( i, recent, last, sky, sky_hot );
+    if ( !owner->data_[i].isPruned() )
+      owner->compare_to_peers( i, cur_start );
+  } else {
+    owner->compare_to_skyline_points( next_start + j - num_cand, 0, last,
+        sky, sky_hot );
+  }
 }
 
 /**
@@ -250,6 +539,15 @@ void inline Hybrid::update_partition_map( const uint32_t start, const uint32_t e
  * to PSFS from the PSkyline paper and to GGS from the GPU skyline
  * paper).
  *
+ * The alpha blocks are pipelined: while Phase II confirms the 
+ * candidates of block k, the same team of threads already runs 
+ * Phase I of block k+1 against the skyline points confirmed up to 
+ * block k-1. The skyline points that block k contributes are compared 
+ * to block k+1 at the start of its own Phase II (see 
+ * compare_to_skyline_points() with the recent range), so the result is
+ * identical to the non-pipelined execution. The partition map is only
+ * modified in the sequential update step, when no thread reads it.
+ *
  * @note Modifies the data_ member so that the skyline tuples
  * appear at the front. May overwrite/delete other data.
  * @return The number of skyline tuples in data_.
@@ -258,107 +556,272 @@ void inline Hybrid::update_partition_map( const uint32_t start, const uint32_t e
  * @see H Im et al. "Parallel skyline computation on multicore 
  * architectures." Information Systems: 36(4). 808--823. 2011.
  */
-int Hybrid::skyline() {
-  uint32_t i, head, start, stop; //cursors
-
-  // D[0...(head - 1)] = skyline tuples
-  // D[start...stop - 1] = current working window
-  head = 0;
-  start = 0;
-
-  /* Init partition map. Consists of pairs: ( bitmap, start index in D ). */
-  part_map_.push_back( pair<uint32_t, uint32_t>( data_[0].getPartition(), 0 ) ); //first part.
-  part_map_.push_back( pair<uint32_t, uint32_t>( data_[0].getPartition(), 1 ) ); //sentinel
-
-  // D[next] = tuple to be considered next
-  while ( start < n_ ) {
-    INI_PROFILER();
-    /* Check in parallel each of the next N_ACCUM
-     * points to see if any are dominated by the
-     * so-far-confirmed skyline points.
-     */
-    stop = start + accum_;
-    if ( stop > n_ )
-      stop = n_;
+TupleIdx Hybrid::skyline() {
+  TupleIdx head = 0; // D[0...(head - 1)] = skyline tuples
 
-#pragma omp parallel for schedule(dynamic, 16) default(shared) private(i)
-    for (i = start; i < stop; ++i) {
-      compare_to_skyline_points( data_[i] );
-    } // END PARALLEL FOR
-    UPD_PROFILER( "11 phaseI" );
+  // D[cur_start...cur_stop - 1] = candidates waiting for Phase II
+  // D[next_start...next_start + accum_ - 1] = block waiting for Phase I
+  TupleIdx cur_start = 0, cur_stop = 0, next_start = 0;
 
-    /* Sequentially compress these points in advance
-     * of comparing amongst themselves.
-     */
-    sort( data_ + start, data_ + stop );
-    for (i = start; i < stop && !data_[i].isPruned(); ++i)
-      ;
-    stop = i;
-    UPD_PROFILER( "13 compress" );
-
-    /* In parallel, confirm all new candidates against
-     * each other to see if any are dominated.
-     */
-#pragma omp parallel for schedule(dynamic, 16) default(shared) private(i)
-    for (i = start; i < stop; ++i) {
-      compare_to_peers( i, start );
-    } // END PARALLEL FOR
-    UPD_PROFILER( "12 phaseII" );
+  /* Init partition map with the first partition, the pivot of which 
+   * (the first point in sorted order) is certainly a skyline point. */
+  part_index_.Insert( data_[0].getPartition(), 0 );
+  part_map_.push_back( PartitionNode( data_[0].getPartition(), 0 ) );
 
-    /* Finally, sequentially compress the confirmed
-     * skyline points again.
-     */
-    const uint32_t head_old = head;
-    sort( data_ + start, data_ + stop );
-    for (i = start; i < stop && !data_[i].isPruned(); ++i, ++head) {
-      data_[head] = data_[i];
+  /* First partition in part_map_ not yet seen by the candidates. */
+  uint32_t recent = part_map_.size();
+
+  /* In NUMA mode, the skyline region D[0...head - 1] is copied to every
+   * socket, and D[refresh_from...head - 1] is (re)copied after each block. 
+   */
+  TupleIdx refresh_from = 0;
+  if ( numa_ ) {
+    for (uint32_t s = 0; s < num_sockets_; ++s) {
+      replicas_.push_back( AllocBuffer<EPTUPLE>( n_ ) );
+      hot_replicas_.push_back( AllocBuffer<HTUPLE>( n_ ) );
     }
-    /* Update partition map with new tuples and advance start pos. */
-    update_partition_map( head_old, head );
-    start += accum_;
-    UPD_PROFILER( "13 compress" );
   }
+
+  INI_PROFILER();
+#pragma omp parallel num_threads(num_threads_) default(shared)
+  {
+    /* Find this thread's socket and its rank among the threads there. */
+    const uint32_t th = omp_get_thread_num();
+    const uint32_t nt = omp_get_num_threads();
+    uint32_t socket = 0, rank = th, peers = nt;
+    if ( numa_ ) {
+      thread_socket_[th] = GetCurrentSocket();
+#pragma omp barrier
+      socket = thread_socket_[th];
+      rank = peers = 0;
+      for (uint32_t t = 0; t < nt; ++t) {
+        if ( thread_socket_[t] == socket ) {
+          if ( t < th )
+            ++rank;
+          ++peers;
+        }
+      }
+      if ( rank == 0 ) {
+        replicas_[socket][0] = data_[0]; // pivot of first partition
+        hot_replicas_[socket][0] = hot_[0];
+      }
+#pragma omp barrier
+    }
+    const EPTUPLE* sky = numa_ ? replicas_[socket] : data_;
+    const HTUPLE* sky_hot = numa_ ? hot_replicas_[socket] : hot_;
+
+    while ( cur_start < cur_stop || next_start < n_ ) {
+      const TupleIdx next_stop =
+          next_start + accum_ < n_ ? next_start + accum_ : n_;
+      const uint32_t last = part_map_.size();
+
+      /* Phase II of block k: first check the candidates against the
+       * skyline points confirmed since their Phase I, then confirm
+       * them against each other. Phase I of block k+1: check each of 
+       * the next alpha points to see if any are dominated by the skyline
+       * points confirmed so far. Both run as one work-stealing loop, so
+       * idle threads continue directly with the other phase.
+       */
+      BlockTask task = { this, cur_start, cur_stop, next_start, recent, last,
+          sky, sky_hot };
+      scheduler_.ForEach( 0, (cur_stop - cur_start) + (next_stop - next_start),
+          WS_DEFAULT_GRAIN, task );
+
+      // Both phases are charged to phase I, as they are no longer apart:
+#pragma omp master
+      UPD_PROFILER( "11 phaseI" );
+
+      /* Compress the confirmed skyline points of block k to the end of
+       * the skyline and the candidates of block k+1 in place (in advance
+       * of comparing them amongst themselves). Both blocks are already
+       * sorted, so a stable compaction keeps them sorted.
+       */
+      const TupleIdx num_sky = compactor_.Compact( data_ + cur_start,
+          cur_stop - cur_start, data_ + head, NotPruned<EPTUPLE>() );
+      const TupleIdx num_cand = compactor_.Compact( data_ + next_start,
+          next_stop - next_start, data_ + next_start, NotPruned<EPTUPLE>() );
+
+#pragma omp single
+      {
+        /* Add the new skyline points to the partition map. */
+        recent = part_map_.size();
+        refresh_from = head;
+        if ( num_sky > 0 ) {
+          recent = part_map_.size() - 1; // last partition may be extended
+          refresh_from = part_map_[recent].begin; // may be reordered
+          update_partition_map( head, head + num_sky );
+          head += num_sky;
+        }
+        cur_start = next_start;
+        cur_stop = next_start + num_cand;
+        next_start = next_stop;
+        UPD_PROFILER( "13 compress" );
+      } // END SINGLE
+
+      /* Reload the hot fields of the points that have been moved or 
+       * re-coded: the changed part of the skyline and the candidates. */
+#pragma omp for schedule(static)
+      for (TupleIdx i = refresh_from; i < head; ++i) {
+        hot_[i].load( data_[i] );
+      } // END PARALLEL FOR
+#pragma omp for schedule(static)
+      for (TupleIdx i = cur_start; i < cur_stop; ++i) {
+        hot_[i].load( data_[i] );
+      } // END PARALLEL FOR
+
+      /* Refresh the changed part of each socket's skyline replica, 
+       * splitting the copy amongst the threads of that socket. */
+      if ( numa_ ) {
+        if ( refresh_from < head ) {
+          const TupleIdx len = head - refresh_from;
+          const TupleIdx lo = refresh_from + (uint64_t) len * rank / peers;
+          const TupleIdx hi = refresh_from
+              + (uint64_t) len * (rank + 1) / peers;
+          std::copy( data_ + lo, data_ + hi, replicas_[socket] + lo );
+          std::copy( hot_ + lo, hot_ + hi, hot_replicas_[socket] + lo );
+        }
+#pragma omp barrier
+      }
+    }
+  } // END PARALLEL
   return head;
 }
 
 /**
- * Partitions the data by the median values on each dimension 
- * and sorts the data by their new partition.
+ * Selects the pivot relative to which the data is partitioned. Rather 
+ * than scanning (or sorting) the whole dataset, every policy works on a 
+ * uniform random sample of PIVOT_SAMPLE_SIZE tuples (or all of them, if 
+ * there are fewer):
+ *  - PIVOT_MEDIAN: the virtual point of per-dimension sample medians, 
+ *    found with a selection (nth_element) per dimension in parallel.
+ *  - PIVOT_BALANCED: the sample point with minimum normalised range.
+ *  - PIVOT_BALSKY: as PIVOT_BALANCED, but a skyline point of the sample.
+ *  - PIVOT_VOLUME: the sample point with maximum dominance volume, i.e.,
+ *    product of normalised complements (1 - x).
+ *  - PIVOT_MANHATTAN: the sample point with minimum Manhattan norm.
+ *  - PIVOT_RANDOM: a random point.
+ * (See PivotCost() for the costs of the point-based policies.)
+ * The median gives the most balanced partitions; the point-based 
+ * policies only need one pass over the sample.
+ *
+ * @param pivot Output parameter into which the pivot values are written.
+ * @param tuples The array of which the n_ remaining tuples are sampled.
+ * @param idx If not NULL, the remaining tuples are tuples[idx[0...n_-1]] 
+ * (rather than tuples[0...n_-1]).
  */
-void inline Hybrid::partition() {
-  /* transpose data for median calculation. */
-  float *data = new float[NUM_DIMS * n_];
+template<typename T>
+void Hybrid::select_pivot( TUPLE &pivot, const T* tuples,
+    const TupleIdx* idx ) {
+  const uint32_t s = n_ < PIVOT_SAMPLE_SIZE ? n_ : PIVOT_SAMPLE_SIZE;
+
+  /* Draw the sample (with replacement, by a fixed-seed xorshift). */
+  TupleIdx *sample = AllocBuffer<TupleIdx>( s );
+  if ( s == n_ ) {
+    for (uint32_t i = 0; i < s; i++)
+      sample[i] = i;
+  } else {
+    TupleIdx x = RANDOM_SEED;
+    for (uint32_t i = 0; i < s; i++) {
+      sample[i] = NextRandom( x ) % n_;
+    }
+  }
+  if ( idx != NULL ) {
+    for (uint32_t i = 0; i < s; i++)
+      sample[i] = idx[sample[i]];
+  }
+
+  if ( pivot_type_ == PIVOT_MEDIAN ) {
+    /* Select the median of each dimension of the sample. */
+    float *column = AllocBuffer<float>( NUM_DIMS * s );
+#pragma omp parallel for num_threads(num_threads_)
+    for (uint32_t j = 0; j < NUM_DIMS; j++) {
+      float * const col = column + j * s;
+      for (uint32_t i = 0; i < s; i++) {
+        col[i] = tuples[sample[i]].elems[j];
+      }
+      std::nth_element( col, col + s / 2, col + s );
+      pivot.elems[j] = col[s / 2];
+    } // END PARALLEL FOR
+    FreeBuffer( column );
+  } else if ( pivot_type_ == PIVOT_RANDOM ) {
+    /* Draw the point, since the sample is not random if s == n_. */
+    TupleIdx x = RANDOM_SEED;
+    pivot = tuples[sample[NextRandom( x ) % s]];
+  } else {
+    /* Normalise relative to the bounds of the sample. */
+    float mins[NUM_DIMS], ranges[NUM_DIMS];
+    for (uint32_t j = 0; j < NUM_DIMS; j++) {
+      float lo = tuples[sample[0]].elems[j], hi = lo;
+      for (uint32_t i = 1; i < s; i++) {
+        lo = std::min( lo, tuples[sample[i]].elems[j] );
+        hi = std::max( hi, tuples[sample[i]].elems[j] );
+      }
+      mins[j] = lo;
+      ranges[j] = hi > lo ? hi - lo : 1;
+    }
+
+    /* Find the sample point with the lowest cost under the policy. */
+    float best_cost = 0;
+    uint32_t best = s;
 #pragma omp parallel num_threads(num_threads_)
-  {
-    const uint32_t th_id = omp_get_thread_num();
+    {
+      float my_best_cost = 0;
+      uint32_t my_best = s;
 #pragma omp for nowait
-    for (uint32_t i = 0; i < n_; i++) {
-      for (uint32_t j = 0; j < NUM_DIMS; j++) {
-        data[j * n_ + i] = data_[i].elems[j];
+      for (uint32_t i = 0; i < s; i++) {
+        const float cost = PivotCost( pivot_type_, tuples[sample[i]].elems,
+            mins, ranges );
+        if ( my_best == s || cost < my_best_cost ) {
+          my_best_cost = cost;
+          my_best = i;
+        }
+      }
+#pragma omp critical
+      {
+        if ( my_best != s && (best == s || my_best_cost < best_cost
+            || (my_best_cost == best_cost && my_best < best)) ) {
+          best_cost = my_best_cost;
+          best = my_best;
+        }
+      }
+    } // END PARALLEL
+
+    /* For PIVOT_BALSKY, replace the point by its dominator in the sample
+     * of least Manhattan norm, which is a skyline point of the sample. */
+    if ( pivot_type_ == PIVOT_BALSKY ) {
+      const TUPLE candidate = tuples[sample[best]];
+      float best_norm = PivotCost( PIVOT_MANHATTAN, candidate.elems, mins,
+          ranges );
+      for (uint32_t i = 0; i < s; i++) {
+        const TUPLE &t = tuples[sample[i]];
+        if ( DominateLeft( t, candidate ) ) {
+          const float norm = PivotCost( PIVOT_MANHATTAN, t.elems, mins,
+              ranges );
+          if ( norm < best_norm ) {
+            best_norm = norm;
+            best = i;
+          }
+        }
       }
     }
-  } // END PARALLEL FOR
-
-  /* Sort each dimension and retrieve median. Note that these
-   * indices are not linked really with the indices in the data_ array
-   * anymore (nor need be).
-   */
-  PTUPLE median;
-  for (uint32_t i = 0; i < NUM_DIMS; i++) {
-#if defined(_OPENMP)
-    std::__parallel::sort( data + i * n_, data + (i + 1) * n_ );
-#else
-    std::sort( data + i * n_, data + (i + 1) * n_ );
-#endif
-    median.elems[i] = data[i * n_ + n_ / 2];
+    pivot = tuples[sample[best]];
   }
-  delete[] data;
+  FreeBuffer( sample );
+}
+
+/**
+ * Partitions the data relative to the pivot selected by select_pivot() 
+ * (by default, the median values on each dimension).
+ */
+void inline Hybrid::partition() {
+  TUPLE pivot;
+  select_pivot<EPTUPLE>( pivot, data_, NULL );
   UPD_PROFILER( "02 select pivot" );
 
-  /* Calc partition relative to median values. */
+  /* Calc partition relative to pivot values. */
 #pragma omp parallel for
-  for (uint32_t i = 0; i < n_; i++) {
-    data_[i].setPartition( DT_bitmap( data_[i], median ) );
+  for (TupleIdx i = 0; i < n_; i++) {
+    data_[i].setPartition( DT_bitmap( data_[i], pivot ) );
   } // END PARALLEL FOR
   UPD_PROFILER( "03 partition" );
 
@@ -11,42 +11,152 @@
 #include <cstdio>
 
 #include "common/common.h"
+#include "common/compaction.h"
+#include "common/lattice_index.h"
 #include "common/skyline_i.h"
+#include "common/work_stealing.h"
 
 using namespace std;
 
+/**
+ * The hot fields of an EPTUPLE: its partition code and its score. Kept
+ * in a packed array parallel to the data array, so that the skip checks
+ * of Phases I and II touch 8 bytes per tuple rather than a cache line.
+ * The partition code has the same encoding as EPTUPLE::partition.
+ */
+typedef struct HTUPLE {
+  uint32_t partition;
+  float score;
+
+  inline void load( const EPTUPLE &t ) {
+    partition = t.partition;
+    score = t.score;
+  }
+  inline void markPruned() {
+    partition = NUM_DIMS << NUM_DIMS;
+  }
+  inline bool isPruned() const {
+    return partition == NUM_DIMS << NUM_DIMS;
+  }
+  inline bool canskip_partition( const uint32_t other ) const {
+    return (getPartition() ^ other) & other;
+  }
+  inline uint32_t getLevel() const {
+    return partition >> NUM_DIMS;
+  }
+  inline uint32_t getPartition() const {
+    return partition & ALL_ONES;
+  }
+} HTUPLE;
+
+/**
+ * A (sub-)partition of the confirmed skyline points, stored as a 
+ * contiguous range of the data array. The first point of the range is
+ * the pivot of the partition. The remaining points are either covered by
+ * child partitions (relative to this pivot) or scanned linearly, in which
+ * case their partition member holds their lattice code relative to this
+ * pivot.
+ */
+typedef struct PartitionNode {
+  uint32_t code; /**< Bitmap relative to the pivot of the parent */
+  TupleIdx begin; /**< Index in the data array of this partition's pivot */
+  TupleIdx split_end; /**< Points [begin + 1, split_end) are in children */
+  TupleIdx end; /**< Points [split_end, end) are scanned linearly */
+  TupleIdx first_child; /**< Index of the first child in sub_parts_ */
+  uint32_t num_children; /**< Number of (consecutive) children */
+
+  PartitionNode( const uint32_t c, const TupleIdx b ) :
+      code( c ), begin( b ), split_end( b + 1 ), end( b + 1 ),
+      first_child( 0 ), num_children( 0 ) {
+  }
+} PartitionNode;
+
 class Hybrid: public SkylineI {
 public:
-  Hybrid(uint32_t threads, uint32_t tuples, uint32_t dims,
-      const uint32_t accum, const uint32_t q_size );
+  Hybrid(uint32_t threads, TupleIdx tuples, uint32_t dims,
+      const uint32_t accum, const uint32_t q_size,
+      const uint32_t pivot_type = PIVOT_MEDIAN,
+      const uint32_t split_size = DEFAULT_SPLIT_SIZE,
+      const uint32_t max_depth = DEFAULT_MAX_DEPTH,
+      const bool numa = false, const float sample_ratio = 0 );
   virtual ~Hybrid();
 
-  vector<int> Execute();
+  vector<TupleId> Execute();
   void Init(float** data);
+  void InitShared(const SharedDataset &data);
 
   void printPartitionSizes() {
     printf( "Created %lu non-empty partitions:\n", part_map_.size() );
-    for (uint32_t i = 1; i < part_map_.size(); i++) {
-      printf( "%u\n", part_map_.at( i ).second - part_map_.at( i - 1 ).second );
+    for (uint32_t i = 0; i < part_map_.size(); i++) {
+      printf( "%llu\n", (unsigned long long) (part_map_.at( i ).end
+          - part_map_.at( i ).begin) );
     }
   }
 
 private:
-  int skyline();
+  TupleIdx skyline();
   void inline partition();
-  void inline compare_to_skyline_points( EPTUPLE &t );
-  void inline compare_to_peers( const uint32_t i, const uint32_t start );
-  void inline update_partition_map( const uint32_t start, const uint32_t end );
+  template<typename T>
+  void select_pivot( TUPLE &pivot, const T* tuples, const TupleIdx* idx );
+  void inline sort();
+  void inline compare_to_skyline_points( const TupleIdx i,
+      const uint32_t first, const uint32_t last, const EPTUPLE* sky,
+      const HTUPLE* sky_hot );
+  bool compare_to_partition( const EPTUPLE &t, const PartitionNode &node,
+      const EPTUPLE* sky, const HTUPLE* sky_hot );
+  void inline compare_to_peers( const TupleIdx i, const TupleIdx start );
+  void inline update_partition_map( const TupleIdx start, const TupleIdx end );
+  void split_partition( PartitionNode &node, const uint32_t depth );
+
+  /* Phase II of the candidates in [cur_start, cur_stop) followed by Phase I
+   * of the block [next_start, ...), as one iteration space. */
+  struct BlockTask {
+    Hybrid* const owner;
+    const TupleIdx cur_start, cur_stop, next_start;
+    const uint32_t recent, last;
+    const EPTUPLE* sky;
+    const HTUPLE* sky_hot;
+    inline void operator()( const TupleIdx j ) const;
+  };
+
+  /* Visits the partitions part_map_[first...last) found in part_index_. */
+  struct PartitionVisitor {
+    Hybrid* const owner;
+    const EPTUPLE &t;
+    const uint32_t first, last;
+    const EPTUPLE* sky;
+    const HTUPLE* sky_hot;
+    inline bool operator()( const uint32_t p ) const {
+      return p >= first && p < last
+          && owner->compare_to_partition( t, owner->part_map_[p], sky,
+              sky_hot );
+    }
+  };
 
   // Data members:
   const uint32_t num_threads_; /**< Number of threads with which to execute */
-  uint32_t n_; /**< Number of input tuples remaining */
+  TupleIdx n_; /**< Number of input tuples remaining */
   const uint32_t accum_; /**< Size of alpha block of points to concurrently process */
   const uint32_t pq_size_; /**< Number of points to use for each thread in the pre-filter */
+  const uint32_t pivot_type_; /**< Pivot policy (one of the PIVOT_* constants) */
+  const uint32_t split_size_; /**< Partitions scanning more points than this are split */
+  const uint32_t max_depth_; /**< Maximum number of levels of partitioning */
+  const bool numa_; /**< Whether to replicate the skyline on each socket */
+  const uint32_t num_sockets_; /**< Number of sockets (in NUMA mode) */
+  const float sample_ratio_; /**< Sample ratio for the sample-skyline filter (0 = off) */
 
   EPTUPLE* data_; /**< Array of input data points */
-  vector<int> skyline_; /**< Vector in which the skyline result will be copied */
-  vector<pair<uint32_t, uint32_t> > part_map_; /**< Data structure used in Phase I computation */
+  HTUPLE* hot_; /**< Hot fields of data_ (see HTUPLE), index for index */
+  vector<TupleId> skyline_; /**< Vector in which the skyline result will be copied */
+  vector<PartitionNode> part_map_; /**< Top-level partitions used in Phase I computation */
+  vector<PartitionNode> sub_parts_; /**< Nested partitions of large partitions */
+  LatticeIndex part_index_; /**< Index into part_map_ by partition bitmap */
+  ParallelCompactor<EPTUPLE> compactor_; /**< Removes pruned tuples from alpha blocks */
+  EPTUPLE* staging_; /**< Buffer of compactor_, for one alpha block */
+  WorkStealingScheduler scheduler_; /**< Balances Phase I/II across threads */
+  vector<EPTUPLE*> replicas_; /**< Per-socket copies of the skyline (in NUMA mode) */
+  vector<HTUPLE*> hot_replicas_; /**< Per-socket copies of its hot fields */
+  uint32_t* thread_socket_; /**< Socket on which each thread runs (in NUMA mode) */
 };
 
 #endif /* HYBRID_H_ */
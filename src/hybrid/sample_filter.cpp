@@ -0,0 +1,93 @@
+/*
+ * sample_filter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "hybrid/sample_filter.h"
+
+#include <algorithm>
+
+#include "common/radix_sort.h"
+#include "hybrid/hybrid.h"
+
+/*
+ * Computes the skyline of the s sample tuples with Hybrid, and groups it
+ * by lattice bitmap relative to the per-dimension medians of the skyline.
+ */
+SampleFilter::SampleFilter( float** sample, const TupleIdx s,
+    const uint32_t num_threads, Arena* arena ) :
+    index_( NUM_DIMS ) {
+  const uint32_t alpha = s < DEFAULT_ALPHA ? s / 2 : DEFAULT_ALPHA;
+  Hybrid hybrid( num_threads, s, NUM_DIMS, alpha, DEFAULT_QP_SIZE );
+  hybrid.SetArena( arena );
+  hybrid.Init( sample );
+  const vector<TupleId> ids = hybrid.Execute();
+  const TupleIdx m = ids.size();
+
+  /* Select the median of each dimension of the sample skyline. */
+  vector<float> column( m );
+  for (uint32_t j = 0; j < NUM_DIMS; j++) {
+    for (TupleIdx i = 0; i < m; i++)
+      column[i] = sample[ids[i]][j];
+    std::nth_element( column.begin(), column.begin() + m / 2, column.end() );
+    pivot_.elems[j] = column[m / 2];
+  }
+
+  /* Sort the skyline by (bitmap, Manhattan norm). */
+  vector<TUPLE> points( m );
+  vector<float> scores( m );
+  KeyIndex* keys = AllocateIn<KeyIndex>( arena, m );
+  for (TupleIdx i = 0; i < m; i++) {
+    memcpy( points[i].elems, sample[ids[i]], sizeof(float) * NUM_DIMS );
+    points[i].pid = ids[i];
+    scores[i] = 0;
+    for (uint32_t j = 0; j < NUM_DIMS; j++)
+      scores[i] += points[i].elems[j];
+    keys[i].key = ((uint64_t) Bitmap( points[i] ) << 32)
+        | FloatToKey( scores[i] );
+    keys[i].idx = i;
+  }
+  KeyIndex* scratch = AllocateIn<KeyIndex>( arena,
+      ParallelRadixSort::ScratchSize( m, num_threads ) );
+  ParallelRadixSort::Sort( keys, m, num_threads, scratch );
+  ReleaseIn( arena, scratch );
+
+  /* Copy out in sorted order, starting a new group at each new bitmap. */
+  sky_.resize( m );
+  scores_.resize( m );
+  for (TupleIdx i = 0; i < m; i++) {
+    sky_[i] = points[keys[i].idx];
+    scores_[i] = scores[keys[i].idx];
+    const uint32_t code = keys[i].key >> 32;
+    if ( group_codes_.empty() || group_codes_.back() != code ) {
+      index_.Insert( code, group_codes_.size() );
+      group_codes_.push_back( code );
+      group_begin_.push_back( i );
+    }
+  }
+  group_begin_.push_back( m );
+  ReleaseIn( arena, keys );
+}
+
+/*
+ * Returns true iff some sample skyline point dominates t. Only groups
+ * whose bitmaps are subsets of t's can contain such a point; these are
+ * enumerated from the index if that is cheaper than scanning all groups.
+ */
+bool SampleFilter::IsDominated( const TUPLE &t ) const {
+  const uint32_t bitmap = Bitmap( t );
+  float score = 0;
+  for (uint32_t j = 0; j < NUM_DIMS; j++)
+    score += t.elems[j];
+
+  GroupVisitor visit = { this, t, score };
+  if ( index_.SubsetCost( bitmap ) < group_codes_.size() )
+    return index_.ForEachSubset( bitmap, visit );
+
+  for (uint32_t g = 0; g < group_codes_.size(); ++g) {
+    if ( !(group_codes_[g] & ~bitmap) && visit( g ) )
+      return true;
+  }
+  return false;
+}
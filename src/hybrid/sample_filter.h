@@ -0,0 +1,116 @@
+/*
+ * sample_filter.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Skyline filter based on the skyline of a random sample. The sample
+ *  skyline is computed with Hybrid and grouped by lattice bitmap relative
+ *  to its median, so that each tuple is only compared to the groups that
+ *  can contain a point that dominates it.
+ */
+
+#ifndef SAMPLE_FILTER_H_
+#define SAMPLE_FILTER_H_
+
+#include <vector>
+
+#include "common/arena.h"
+#include "common/common.h"
+#include "common/lattice_index.h"
+
+using namespace std;
+
+class SampleFilter {
+public:
+
+  /*
+   * Removes from data the tuples that are dominated by a skyline point of
+   * a random sample of ratio * n tuples (drawn with replacement). Does
+   * nothing if the sample would have fewer than SAMPLE_FILTER_MIN tuples.
+   * Surviving tuples are compacted to the front of data, not in order.
+   * The temporary buffers are taken from arena (see AllocateIn()).
+   *
+   * Returns the number of surviving tuples.
+   */
+  template<typename T>
+  static TupleIdx Execute( T* data, const TupleIdx n, const float ratio,
+      const uint32_t num_threads, Arena* arena );
+
+private:
+  SampleFilter( float** sample, const TupleIdx s, const uint32_t num_threads,
+      Arena* arena );
+
+  bool IsDominated( const TUPLE &t ) const;
+
+  inline uint32_t Bitmap( const TUPLE &t ) const {
+    uint32_t bitmap = 0;
+    for (uint32_t j = 0; j < NUM_DIMS; ++j)
+      if ( t.elems[j] > pivot_.elems[j] )
+        bitmap |= SHIFTS[j];
+    return bitmap;
+  }
+
+  /* Compares t to the sample skyline points in one group, in ascending
+   * order of Manhattan norm, until they are too large to dominate t. */
+  struct GroupVisitor {
+    const SampleFilter* const owner;
+    const TUPLE &t;
+    const float score;
+    inline bool operator()( const uint32_t g ) const {
+      for (TupleIdx i = owner->group_begin_[g];
+          i < owner->group_begin_[g + 1] && owner->scores_[i] <= score; ++i) {
+        if ( DominateLeft( owner->sky_[i], t ) )
+          return true;
+      }
+      return false;
+    }
+  };
+
+  // Data members:
+  TUPLE pivot_; /**< Per-dimension median of the sample skyline */
+  vector<TUPLE> sky_; /**< Sample skyline, sorted by (bitmap, score) */
+  vector<float> scores_; /**< Manhattan norm of each point in sky_ */
+  vector<uint32_t> group_codes_; /**< Bitmap of each group */
+  vector<TupleIdx> group_begin_; /**< Group g is sky_[begin[g], begin[g+1]) */
+  LatticeIndex index_; /**< Bitmap -> group */
+};
+
+// Templated static function has to be defined in a header file..
+
+template<typename T>
+TupleIdx SampleFilter::Execute( T* data, const TupleIdx n, const float ratio,
+    const uint32_t num_threads, Arena* arena ) {
+  const TupleIdx s = (TupleIdx) (n * ratio);
+  if ( s < SAMPLE_FILTER_MIN )
+    return n;
+
+  /* Draw the sample (with replacement, by a fixed-seed xorshift). */
+  float** sample = AllocateIn<float*>( arena, s );
+  TupleIdx x = RANDOM_SEED;
+  for (TupleIdx i = 0; i < s; i++) {
+    sample[i] = data[NextRandom( x ) % n].elems;
+  }
+  const SampleFilter filter( sample, s, num_threads, arena );
+  ReleaseIn( arena, sample );
+
+  bool* pruned = AllocateIn<bool>( arena, n );
+#pragma omp parallel for num_threads(num_threads)
+  for (TupleIdx i = 0; i < n; ++i) {
+    pruned[i] = filter.IsDominated( data[i] );
+  } // END PARALLEL FOR
+
+  /* Determine how many points were pruned. */
+  TupleIdx new_n = n;
+  for (TupleIdx i = 0; i < new_n; ++i) {
+    if ( pruned[i] ) {
+      --new_n;
+      data[i] = data[new_n];
+      pruned[i--] = pruned[new_n];
+    }
+  }
+  ReleaseIn( arena, pruned );
+
+  return new_n;
+}
+
+#endif /* SAMPLE_FILTER_H_ */
@@ -13,6 +13,8 @@
 #include <cassert>
 #include <strings.h>
 
+#include "hybrid/sample_filter.h"
+
 #if defined(_OPENMP)
 #include <omp.h>
 #include <parallel/algorithm>
@@ -22,29 +24,36 @@
 #define omp_set_num_threads( t ) 0
 #endif
 
-PSkyline::PSkyline(uint32_t threads, uint32_t n, uint32_t d, float** data) :
-    num_threads_( threads ), n_( n ), d_( d ), block_size_( n / threads ) {
+PSkyline::PSkyline(uint32_t threads, TupleIdx n, uint32_t d, float** data,
+    const float sample_ratio) :
+    num_threads_( threads ), num_blocks_( threads ), n_( n ), d_( d ),
+    block_size_( n / threads ),
+    sample_ratio_( sample_ratio ),
+    compactor_( threads ), scheduler_( threads ) {
   skyline_.reserve( 1024 );
   omp_set_num_threads( num_threads_ );
   data_ = NULL;
+  shared_ = NULL;
   input_ = NULL;
   flag_ = NULL;
+  staging_ = NULL;
 }
 
 PSkyline::~PSkyline() {
-  delete[] data_;
+  FreeBuffer( data_ );
   delete[] input_;
-  delete[] flag_;
+  FreeBuffer( flag_ );
+  FreeBuffer( staging_ );
 }
 
-vector<int> PSkyline::Execute() {
+vector<TupleId> PSkyline::Execute() {
   INI_PROFILER();
   Block* output = PMap( input_ );
   UPD_PROFILER("11 phaseI");
   Block result = SReduce( output );
   UPD_PROFILER("12 phaseII");
 
-  for (uint32_t i = 0; i < result.size; ++i) {
+  for (TupleIdx i = 0; i < result.size; ++i) {
     skyline_.push_back( data_[i].pid );
   }
 
@@ -54,24 +63,56 @@ vector<int> PSkyline::Execute() {
 }
 
 void PSkyline::Init(float** data) {
-  data_ = new TUPLE[n_];
+  data_ = AllocBuffer<TUPLE>( n_ );
 #pragma omp parallel for
-  for (uint32_t i = 0; i < n_; i++) {
+  for (TupleIdx i = 0; i < n_; i++) {
     data_[i].pid = i;
     memcpy( data_[i].elems, data[i], sizeof(float) * NUM_DIMS );
   }
+  n_ = SampleFilter::Execute<TUPLE>( data_, n_, sample_ratio_, num_threads_,
+      arena_ );
+  InitBlocks();
+}
+
+/*
+ * Leaves the copying of the shared tuples to PMap(), in which each thread
+ * copies its own block right before it computes the skyline of it. (The
+ * sample filter has to compact a copy, so falls back to Init() if 
+ * enabled.)
+ */
+void PSkyline::InitShared( const SharedDataset &data ) {
+  if ( sample_ratio_ > 0 ) {
+    Init( data.rows() );
+    return;
+  }
+  shared_ = data.tuples();
+  data_ = AllocBuffer<TUPLE>( n_ );
+  InitBlocks();
+}
 
-  input_ = new Block[num_threads_];
-  flag_ = new int[n_];
-  int start = 0, end = 0;
+void PSkyline::InitBlocks() {
+  /* At least one tuple per block (the filter may leave fewer tuples than
+   * threads). */
+  num_blocks_ = n_ < num_threads_ ? (n_ > 0 ? n_ : 1) : num_threads_;
+  block_size_ = n_ / num_blocks_;
+
+  input_ = new Block[num_blocks_];
+  flag_ = AllocBuffer<int>( n_ );
+  TupleId start = 0, end = 0;
   uint32_t i;
-  for (i = 0; i < num_threads_; i++) {
+  for (i = 0; i < num_blocks_; i++) {
     end = start + block_size_ - 1;
     input_[i].start = start;
     input_[i].end = end;
     start = end + 1;
   }
   input_[i - 1].end = n_ - 1; // .end : inclusive
+
+  /* The merges of Phase II compact up to all n_ tuples. */
+  if ( num_blocks_ > 1 ) {
+    staging_ = AllocBuffer<TUPLE>( n_ );
+    compactor_.SetBuffer( staging_, n_ );
+  }
 }
 
 /*
@@ -82,11 +123,14 @@ void PSkyline::Init(float** data) {
  *
  */
 Block* PSkyline::PMap(Block* input) {
-  Block* output = new Block[num_threads_];
+  Block* output = new Block[num_blocks_];
   #pragma omp parallel for default(shared)
-  for (uint32_t i = 0; i < num_threads_; i++)
+  for (uint32_t i = 0; i < num_blocks_; i++) {
+    if ( shared_ != NULL )
+      std::copy( shared_ + input[i].start, shared_ + input[i].end + 1,
+          data_ + input[i].start );
     output[i] = sskyline( input[i] );
-  // END PARALLEL FOR
+  } // END PARALLEL FOR
   return output;
 }
 
@@ -94,9 +138,9 @@ Block* PSkyline::PMap(Block* input) {
  * Simple Skyline
  */
 Block PSkyline::sskyline(Block input) {
-  int i;
-  const int size = input.end - input.start + 1;
-  int head = 0, tail = size - 1;
+  TupleId i;
+  const TupleId size = input.end - input.start + 1;
+  TupleId head = 0, tail = size - 1;
 
   TUPLE *const D = data_ + input.start;
 
@@ -127,13 +171,13 @@ Block PSkyline::sskyline(Block input) {
  * one by sequentially calling parallel merge.
  */
 Block PSkyline::SReduce(Block* input) {
-  if ( num_threads_ == 1 )
+  if ( num_blocks_ == 1 )
     return input[0];
 
-  Block* buf = new Block[num_threads_];
-  memcpy( buf, input, num_threads_ * sizeof(Block) );
+  Block* buf = new Block[num_blocks_];
+  memcpy( buf, input, num_blocks_ * sizeof(Block) );
   Block ret = buf[0];
-  for (uint32_t i = 1; i <= num_threads_ - 1; i++)
+  for (uint32_t i = 1; i <= num_blocks_ - 1; i++)
     ret = PMerge( ret, buf[i] );
 
   delete[] buf;
@@ -167,19 +211,19 @@ Block PSkyline::PMerge(Block left, Block right) {
   //bzero( flag, (left.size + right.size) * sizeof(int) );
   memset( flag, 0, (left.size + right.size) * sizeof(int) );
 
-#pragma omp parallel for schedule(dynamic, 64)
-  for (uint32_t i = 0; i < left.size; i++) {
-    left_flag[i] = CheckSurvival( left_skyline[i], right_skyline, right_flag,
-        right.size );
-  } // END PARALLEL FOR
-
-  /* Compact skylines */
-  uint32_t cnt = 0;
-  for (uint32_t i = 0; i < left.size + right.size; i++)
-    if ( flag[i] == LIVE )
-      left_skyline[cnt++] = left_skyline[i];
-
-  left.size = cnt;
+  /* Check the left skyline against the right one and compact both
+   * skylines in parallel */
+#pragma omp parallel num_threads(num_threads_)
+  {
+    MergeTask merge = { this, left_skyline, right_skyline, left_flag,
+        right_flag, right.size };
+    scheduler_.ForEach( 0, left.size, WS_DEFAULT_GRAIN, merge );
+
+    const TupleIdx cnt = compactor_.Compact( left_skyline,
+        left.size + right.size, left_skyline, FlagIs<int>( flag, LIVE ) );
+#pragma omp master
+    left.size = cnt;
+  } // END PARALLEL
 
   return left;
 }
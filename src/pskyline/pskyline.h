@@ -22,27 +22,32 @@
 #include <vector>
 
 #include "common/common.h"
+#include "common/compaction.h"
+#include "common/shared_dataset.h"
 #include "common/skyline_i.h"
+#include "common/work_stealing.h"
 
 using namespace std;
 
 typedef struct Block {
-  int start; // data[start --- end], inclusive
-  int end; // flag[start --- end], inclusive
-  uint32_t size; // skyline size after find_skyline
+  TupleId start; // data[start --- end], inclusive
+  TupleId end; // flag[start --- end], inclusive
+  TupleIdx size; // skyline size after find_skyline
   // data[(start --- (start + size - 1)], inclusive after find_skyline
 } Block;
 
 class PSkyline: public SkylineI {
 public:
-  PSkyline(uint32_t threads, uint32_t tuples, uint32_t dims, float** data);
+  PSkyline(uint32_t threads, TupleIdx tuples, uint32_t dims, float** data,
+      const float sample_ratio = 0);
   virtual ~PSkyline();
 
-  vector<int> Execute();
+  vector<TupleId> Execute();
+  void InitShared(const SharedDataset &data);
 
 private:
-  inline int CheckSurvival(TUPLE x, TUPLE* s, int* flag, int size) {
-    for (int i = 0; i < size; i++) {
+  inline int CheckSurvival(TUPLE x, TUPLE* s, int* flag, TupleIdx size) {
+    for (TupleIdx i = 0; i < size; i++) {
       if ( flag[i] == DEAD )
         continue;
       const int dtest = DominanceTest( x, s[i] );
@@ -62,22 +67,43 @@ private:
     return LIVE;
   }
 
+  /* Checks left[i] against the right skyline for PMerge. */
+  struct MergeTask {
+    PSkyline* const owner;
+    TUPLE* left;
+    TUPLE* right;
+    int* left_flag;
+    int* right_flag;
+    const TupleIdx right_size;
+    inline void operator()( const TupleIdx i ) const {
+      left_flag[i] = owner->CheckSurvival( left[i], right, right_flag,
+          right_size );
+    }
+  };
+
   void Init(float** data);
+  void InitBlocks();
   Block sskyline(Block input);
   Block PMerge(Block left, Block right);
   Block* PMap(Block* input);
   Block SReduce(Block* input);
 
   // Data members:
-  const uint32_t num_threads_; // the same as num_blocks (one thread per block)
-  const uint32_t n_; // #tuples
+  const uint32_t num_threads_;
+  uint32_t num_blocks_; // one thread per block; fewer if n_ < num_threads_
+  TupleIdx n_; // #tuples
   const uint32_t d_; // #dims
-  const uint32_t block_size_;
+  TupleIdx block_size_;
+  const float sample_ratio_; // sample ratio for the sample-skyline filter (0 = off)
 
   TUPLE* data_;
+  const TUPLE* shared_; // the shared tuples, if not yet copied to data_
   Block* input_;
   int* flag_;
-  vector<int> skyline_;
+  vector<TupleId> skyline_;
+  ParallelCompactor<TUPLE> compactor_;
+  TUPLE* staging_; // buffer of compactor_
+  WorkStealingScheduler scheduler_;
 };
 
 #endif /* PSKYLINE_H_ */
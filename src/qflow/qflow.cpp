@@ -10,6 +10,9 @@
 #include <cstdio>
 #include <cassert>
 
+#include "common/radix_sort.h"
+#include "hybrid/sample_filter.h"
+
 #if defined(_OPENMP)
 #include <omp.h>
 #include <parallel/algorithm>
@@ -19,147 +22,139 @@
 #define omp_set_num_threads( t ) 0
 #endif
 
-QFlow::QFlow( uint32_t threads, uint32_t n, uint32_t d, float** data,
-    uint32_t accum ) :
-    num_threads_( threads ), n_( n ), accum_(accum) {
+QFlow::QFlow( uint32_t threads, TupleIdx n, uint32_t d, float** data,
+    uint32_t accum, const float sample_ratio, const bool rank ) :
+    num_threads_( threads ), n_( n ), accum_(accum),
+    sample_ratio_( sample_ratio ), rank_( rank ), num_ranks_( 0 ), sorted_( false ),
+    scheduler_( threads ) {
 
   omp_set_num_threads( threads );
   skyline_.reserve( 1024 );
   data_ = NULL;
+  ranks_ = NULL;
+  staging_ = NULL;
 }
 
 QFlow::~QFlow() {
-  delete[] data_;
+  FreeBuffer( data_ );
+  FreeBuffer( ranks_ );
+  FreeBuffer( staging_ );
 }
 
 void QFlow::Init( float** data ) {
-  data_ = new STUPLE[n_];
-  for (uint32_t i = 0; i < n_; i++) {
+  data_ = AllocBuffer<STUPLE>( n_ );
+  for (TupleIdx i = 0; i < n_; i++) {
     data_[i].pid = i;
     for (uint32_t j = 0; j < NUM_DIMS; j++) {
       data_[i].elems[j] = data[i][j];
     }
   }
+  if ( rank_ )
+    InitRanks( data );
+  staging_ = AllocBuffer<STUPLE>( accum_ );
 }
 
-bool QFlow::STupleComp( STUPLE const &lhs, STUPLE const &rhs ) {
-  if ( lhs.score < rhs.score )
-    return true;
-  if ( rhs.score < lhs.score )
-    return false;
-  // if a tie, sort by manhattan norm:
-  float lhs_sum = lhs.elems[0];
-  float rhs_sum = rhs.elems[0];
-  for (uint32_t d = 1; d < NUM_DIMS; ++d) {
-    lhs_sum += lhs.elems[d];
-    rhs_sum += rhs.elems[d];
+/*
+ * Rather than copying the shared tuples and then sorting the copy, sorts
+ * an index permutation of them by score and gathers the working copy 
+ * once, already in sorted order. (The sample filter has to see the whole
+ * unsorted input, so falls back to Init() if enabled.)
+ */
+void QFlow::InitShared( const SharedDataset &data ) {
+  if ( sample_ratio_ > 0 ) {
+    Init( data.rows() );
+    return;
   }
-  return lhs_sum < rhs_sum;
+
+  const TUPLE* tuples = data.tuples();
+  KeyIndex* keys = AllocBuffer<KeyIndex>( n_ );
+#pragma omp parallel for
+  for (TupleIdx i = 0; i < n_; i++) {
+    float score = tuples[i].elems[0];
+    for (uint32_t j = 1; j < NUM_DIMS; j++) {
+      score += tuples[i].elems[j];
+    }
+    keys[i].key = FloatToKey( score );
+    keys[i].idx = i;
+  } // END PARALLEL FOR
+  KeyIndex* scratch = AllocBuffer<KeyIndex>(
+      ParallelRadixSort::ScratchSize( n_, num_threads_ ) );
+  ParallelRadixSort::Sort( keys, n_, num_threads_, scratch );
+  FreeBuffer( scratch );
+
+  data_ = AllocBuffer<STUPLE>( n_ );
+#pragma omp parallel for
+  for (TupleIdx i = 0; i < n_; i++) {
+    (TUPLE&) data_[i] = tuples[keys[i].idx];
+  } // END PARALLEL FOR
+  FreeBuffer( keys );
+  ComputeScores();
+  sorted_ = true;
+
+  if ( rank_ )
+    InitRanks( data.rows() );
+  staging_ = AllocBuffer<STUPLE>( accum_ );
+}
+
+void QFlow::InitRanks( float** data ) {
+  ranks_ = AllocBuffer<uint32_t>( (size_t) n_ * NUM_DIMS );
+  num_ranks_ = RankTransform::Execute( data, n_, num_threads_, ranks_,
+      arena_ );
 }
 
-vector<int> QFlow::Execute() {
+vector<TupleId> QFlow::Execute() {
   INI_PROFILER();
-  // sort:
-  ComputeScores();
-#if defined(_OPENMP)
-  std::__parallel::sort( data_, data_ + n_, STupleComp );
-#else
-  std::sort( data_, data_ + n_, STupleComp );
-#endif
+  n_ = SampleFilter::Execute<STUPLE>( data_, n_, sample_ratio_, num_threads_,
+      arena_ );
+  // sort (unless InitShared() already has):
+  if ( !sorted_ ) {
+    ComputeScores();
+    SortByScore();
+  }
   UPD_PROFILER("01 pq-filter");
 
-  const int num_survive = skyline();
-  for (uint32_t i = 0; i < num_survive; ++i) {
-    skyline_.push_back( data_[i].pid );
+  if ( num_ranks_ > 0 && num_ranks_ <= 1u << 8 ) {
+    SkylineOfCodes<uint8_t>();
+  } else if ( num_ranks_ > 0 && num_ranks_ <= 1u << 16 ) {
+    SkylineOfCodes<uint16_t>();
+  } else {
+    const TupleIdx num_survive = skyline( data_ );
+    for (TupleIdx i = 0; i < num_survive; ++i) {
+      skyline_.push_back( data_[i].pid );
+    }
   }
   PRI_PROFILER();
 
   return skyline_;
 }
 
-// return = number of surviving tuples
-int QFlow::skyline() {
-  int i, j;
-  int head1, head2, start, stop;
-  float stop_val, candidate_stop_val;
-  bool* sky = new bool[n_]();
-
-  // D[0...(head1 - 1)] = skyline tuples
-  // D[head1...(head2 - 1)] = candidate tuples
-  head1 = 0;
-  head2 = 1;
-  start = 1;
-  sky[0] = true;
-
-  // D[next] = tuple to be considered next
-  while ( start < n_ ) {
-
-    /* Check in parallel each of the next N_ACCUM
-     * points to see if any are dominated by the
-     * so-far-confirmed skyline points.
-     */
-    stop = start + accum_;
-    if ( stop > n_ )
-      stop = n_;
-#pragma omp parallel for default(shared) private(i,j)
-    for (i = start; i < stop; i++) {
-      for (j = 0; j <= head1; j++) {
-        if ( DominateLeft( data_[j], data_[i] ) ) {
-          sky[i] = false;
-          break;
-        }
-      }
-      if ( j == head1 + 1 )
-        sky[i] = true; /* Candidate to continue on. */
-    }
-    UPD_PROFILER("11 phaseI");
-
-    /* Sequentially compress these points in advance
-     * of comparing amongst themselves.
-     */
-    for (i = start, head2 = head1; i < stop; i++) {
-      if ( sky[i] )
-        data_[++head2] = data_[i];
-    }
-    UPD_PROFILER( "13 compress" );
-
-    /* In parallel, confirm all new candidates against
-     * each other to see if any are dominated.
-     */
-#pragma omp parallel for default(shared) private(i,j)
-    for (i = head1 + 1; i <= head2; i++) {
-      const uint32_t end = i;
-      for (j = head1 + 1; j < end; j++) {
-        if ( DominateLeft( data_[j], data_[i] ) ) {
-          sky[i] = false;
-          break;
-        }
-      }
-      if ( j == end )
-        sky[i] = true; /* Legitimately confirmed as skyline. */
-    }
-    UPD_PROFILER( "12 phaseII" );
-
-    /* Finally, sequentially compress the confirmed
-     * skyline points again and check if any update
-     * the SaLSa stop condition.
-     */
-    for (i = head1 + 1; i <= head2; i++) {
-      if ( sky[i] ) {
-        data_[++head1] = data_[i];
-      }
-    }
-    UPD_PROFILER( "13 compress" );
-    start = stop;
-  }
-
-  delete[] sky;
-  return head1 + 1;
+/*
+ * Sorts data_ by score with a parallel radix sort on the score bits and
+ * permutes the tuples once. Since the score is the Manhattan norm, ties
+ * need no further tie-breaking.
+ */
+void QFlow::SortByScore() {
+  KeyIndex* keys = AllocBuffer<KeyIndex>( n_ );
+#pragma omp parallel for
+  for (TupleIdx i = 0; i < n_; i++) {
+    keys[i].key = FloatToKey( data_[i].score );
+    keys[i].idx = i;
+  } // END PARALLEL FOR
+  KeyIndex* scratch = AllocBuffer<KeyIndex>(
+      ParallelRadixSort::ScratchSize( n_, num_threads_ ) );
+  ParallelRadixSort::Sort( keys, n_, num_threads_, scratch );
+  FreeBuffer( scratch );
+
+  STUPLE* sorted = AllocBuffer<STUPLE>( n_ );
+  ParallelRadixSort::Permute( data_, sorted, keys, n_, num_threads_ );
+  FreeBuffer( keys );
+  FreeBuffer( data_ );
+  data_ = sorted;
 }
 
 void QFlow::ComputeScores() {
 #pragma omp parallel for
-  for (uint32_t i = 0; i < n_; i++) {
+  for (TupleIdx i = 0; i < n_; i++) {
     data_[i].score = data_[i].elems[0];
     for (uint32_t j = 1; j < NUM_DIMS; j++) {
       data_[i].score += data_[i].elems[j];
@@ -12,33 +12,176 @@
 #ifndef QFLOW_H_
 #define QFLOW_H_
 
+#include <algorithm>
+
 #include "common/common.h"
+#include "common/compaction.h"
+#include "common/rank_transform.h"
+#include "common/shared_dataset.h"
 #include "common/skyline_i.h"
+#include "common/work_stealing.h"
 
 using namespace std;
 
 class QFlow: public SkylineI {
 public:
-  QFlow( uint32_t threads, uint32_t tuples, uint32_t dims, float** data,
-      uint32_t accum );
+  QFlow( uint32_t threads, TupleIdx tuples, uint32_t dims, float** data,
+      uint32_t accum, const float sample_ratio = 0, const bool rank = false );
   virtual ~QFlow();
 
-  vector<int> Execute();
+  vector<TupleId> Execute();
 
 private:
   void Init( float** data );
-  static bool STupleComp( STUPLE const &lhs, STUPLE const &rhs );
-  int skyline();
+  void InitShared( const SharedDataset &data );
+  template<typename T>
+  TupleIdx skyline( T* data );
+  template<typename C>
+  void SkylineOfCodes();
+  void InitRanks( float** data );
   void ComputeScores();
+  void SortByScore();
+
+  /* Phase I: flags data_[i] iff no skyline point data_[0...head] dominates it. */
+  template<typename T>
+  struct FilterTask {
+    const T* data;
+    bool* sky;
+    const TupleIdx head;
+    inline void operator()( const TupleIdx i ) const {
+      TupleIdx j;
+      for (j = 0; j <= head; j++) {
+        if ( DominateLeft( data[j], data[i] ) )
+          break;
+      }
+      sky[i] = ( j == head + 1 ); /* Candidate to continue on. */
+    }
+  };
+
+  /* Phase II: flags data_[i] iff no candidate data_[first...i-1] dominates it. */
+  template<typename T>
+  struct ConfirmTask {
+    const T* data;
+    bool* sky;
+    const TupleIdx first;
+    inline void operator()( const TupleIdx i ) const {
+      const TupleIdx end = i;
+      TupleIdx j;
+      for (j = first; j < end; j++) {
+        if ( DominateLeft( data[j], data[i] ) )
+          break;
+      }
+      sky[i] = ( j == end ); /* Legitimately confirmed as skyline. */
+    }
+  };
 
   // Data members:
   const uint32_t num_threads_;
-  const uint32_t n_;
+  TupleIdx n_;
   const uint32_t accum_;
+  const float sample_ratio_; // sample ratio for the sample-skyline filter (0 = off)
+  const bool rank_; // whether to run on rank codes (see RankTransform)
+  uint32_t num_ranks_; // max. distinct values per dimension (0 = not ranked)
+  bool sorted_; // whether data_ is already scored and sorted (see InitShared)
 
   STUPLE* data_;
-  vector<int> skyline_;
+  uint32_t* ranks_; // dense ranks, by pid (if rank_)
+  STUPLE* staging_; // buffer of the compactions in skyline(), for accum_ tuples
+  vector<TupleId> skyline_;
+  WorkStealingScheduler scheduler_;
 
 };
 
+// Templated member functions have to be defined in a header file..
+
+// return = number of surviving tuples
+template<typename T>
+TupleIdx QFlow::skyline( T* data ) {
+  /* Rank-code tuples are smaller, so they fit in staging_ too. */
+  static_assert( sizeof(T) <= sizeof(STUPLE), "staging_ too small" );
+  ParallelCompactor<T> compactor( num_threads_ );
+  compactor.SetBuffer( (T*) staging_, accum_ );
+  TupleIdx head1, head2, start, stop;
+  float stop_val, candidate_stop_val;
+  bool* sky = AllocBuffer<bool>( n_ );
+  std::fill( sky, sky + n_, false );
+
+  // D[0...(head1 - 1)] = skyline tuples
+  // D[head1...(head2 - 1)] = candidate tuples
+  head1 = 0;
+  head2 = 1;
+  start = 1;
+  sky[0] = true;
+
+  // D[next] = tuple to be considered next
+  while ( start < n_ ) {
+
+    /* Check in parallel each of the next N_ACCUM
+     * points to see if any are dominated by the
+     * so-far-confirmed skyline points. Then, in parallel,
+     * compress these points in advance of comparing 
+     * amongst themselves.
+     */
+    stop = start + accum_;
+    if ( stop > n_ )
+      stop = n_;
+#pragma omp parallel num_threads(num_threads_)
+    {
+      FilterTask<T> filter = { data, sky, head1 };
+      scheduler_.ForEach( start, stop, WS_DEFAULT_GRAIN, filter );
+#pragma omp master
+      UPD_PROFILER("11 phaseI");
+
+      const TupleIdx num_cand = compactor.Compact( data + start,
+          stop - start, data + head1 + 1, FlagIs<bool>( sky + start, true ) );
+#pragma omp master
+      head2 = head1 + num_cand;
+    } // END PARALLEL
+    UPD_PROFILER( "13 compress" );
+
+    /* In parallel, confirm all new candidates against
+     * each other to see if any are dominated. Finally, 
+     * compress the confirmed skyline points again in parallel.
+     */
+#pragma omp parallel num_threads(num_threads_)
+    {
+      ConfirmTask<T> confirm = { data, sky, head1 + 1 };
+      scheduler_.ForEach( head1 + 1, head2 + 1, WS_DEFAULT_GRAIN, confirm );
+#pragma omp master
+      UPD_PROFILER( "12 phaseII" );
+
+      const TupleIdx num_sky = compactor.Compact( data + head1 + 1,
+          head2 - head1, data + head1 + 1,
+          FlagIs<bool>( sky + head1 + 1, true ) );
+#pragma omp master
+      head1 += num_sky;
+    } // END PARALLEL
+    UPD_PROFILER( "13 compress" );
+    start = stop;
+  }
+
+  FreeBuffer( sky );
+  return head1 + 1;
+}
+
+
+/*
+ * Runs skyline() on the rank codes (of type C) of data_, in the order of
+ * data_, and copies out the ids of the skyline points.
+ */
+template<typename C>
+void QFlow::SkylineOfCodes() {
+  CTUPLE<C>* coded = AllocBuffer<CTUPLE<C> >( n_ );
+#pragma omp parallel for num_threads(num_threads_)
+  for (TupleIdx i = 0; i < n_; i++) {
+    RankTransform::Encode( ranks_, data_[i].pid, coded[i] );
+  } // END PARALLEL FOR
+
+  const TupleIdx num_survive = skyline( coded );
+  for (TupleIdx i = 0; i < num_survive; ++i) {
+    skyline_.push_back( coded[i].pid );
+  }
+  FreeBuffer( coded );
+}
+
 #endif /* QFLOW_H_ */
@@ -7,8 +7,22 @@
  * -t: run with num_threads, e.g., "1 2 4" (default "4")
  *     Note: used only with multi-threaded algorithms
  * -s: skyline algorithms to run, by default runs all
- *     Supported algorithms: bskytree, hybrid, pskyline, qflow, pbskytree
+ *     Supported algorithms: bskytree, hybrid, pskyline, qflow, pbskytree,
+ *     tbskytree
  * -v: verbose mode (don't use for performance experiments!)
+ * -n: NUMA mode (only hybrid): replicate the skyline on each socket
+ * -b: thread affinity policy: none (default), compact, scatter, physical
+ * -p: pivot policy (bskytree, pbskytree, tbskytree, hybrid): random, median,
+ *     balanced, balsky, manhattan, volume (default: median for hybrid,
+ *     balsky otherwise)
+ * -r: sample ratio (hybrid, qflow, pskyline): pre-filter the input with the
+ *     skyline of a random sample of this fraction of it (default 0 = off)
+ * -g: grid filter: eliminate grid cells dominated by occupied cells, once,
+ *     before all runs
+ * -k: rank codes (only qflow): run on uint8_t/uint16_t dense ranks of the
+ *     values when every dimension has at most 2^8/2^16 distinct values
+ * -l: large pages: back the input and the per-run buffers by 2 MB pages
+ *     where available (reported in verbose mode)
  *
  * Example: ./SkyBench -f workloads/house.csv -s "bskytree hybrid"
  *
@@ -27,15 +41,21 @@
 #include "hybrid/hybrid.h"
 #include "util/utilities.h"
 #include "util/timing.h"
+#include "util/affinity.h"
 #include "common/skyline_i.h"
 #include "common/common.h"
+#include "common/grid_filter.h"
+#include "common/pivot_policy.h"
+#include "common/shared_dataset.h"
+#include "common/arena.h"
 
 #define ALG_BSKYTREE "bskytree"
 #define ALG_PBSKYTREE "pbskytree"
 #define ALG_PSKYLINE "pskyline"
 #define ALG_QFLOW "qflow"
 #define ALG_HYBRID "hybrid"
-#define ALG_ALL "bskytree pbskytree pskyline qflow hybrid"
+#define ALG_TBSKYTREE "tbskytree"
+#define ALG_ALL "bskytree pbskytree tbskytree pskyline qflow hybrid"
 
 using namespace std;
 
@@ -43,6 +63,14 @@ typedef struct Config {
   string input_fname;
   uint32_t alpha_size;
   uint32_t pq_size;
+  bool numa;
+  AffinityPolicy affinity;
+  int pivot; // PIVOT_*, or -1 for each algorithm's default
+  float sample_ratio; // for the sample-skyline filter (0 = off)
+  bool grid; // whether to reduce the input with the grid filter
+  bool rank; // whether to run on rank codes (see RankTransform)
+  bool huge; // whether to allocate large buffers on huge pages
+  uint32_t max_threads; // largest of the thread counts
   vector<string> algo;
   vector<string> threads;
   vector<string> dts;
@@ -57,19 +85,100 @@ bool isMC( string alg_name ) {
   return true;
 }
 
+/**
+ * Returns the requested pivot policy, or def if none was requested.
+ */
+uint32_t pivotOr( const int pivot, const uint32_t def ) {
+  return pivot < 0 ? def : (uint32_t) pivot;
+}
+
+/**
+ * Reduces the input with the grid filter, if enabled, and returns the
+ * rows (pointing into data) on which to run the algorithms. Sets m to
+ * their number and ids to their indexes in data.
+ */
+float** reduceInput( Config &cfg, float** data, const TupleIdx n,
+    TupleIdx &m, vector<TupleIdx> &ids ) {
+  m = n;
+  if ( !cfg.grid )
+    return data;
+
+  ids = GridFilter::Execute( data, n, cfg.max_threads );
+  m = ids.size();
+  float** rows = new float*[m];
+  for (TupleIdx i = 0; i < m; ++i)
+    rows[i] = data[ids[i]];
+  if ( m < cfg.alpha_size )
+    cfg.alpha_size = m > 1 ? m / 2 : 1;
+  if ( m < cfg.pq_size )
+    cfg.pq_size = 1;
+  return rows;
+}
+
+/**
+ * Maps the skyline of a run on the reduced rows back to input indexes.
+ */
+void mapToInput( vector<TupleId> &res, const vector<TupleIdx> &ids ) {
+  if ( ids.empty() )
+    return;
+  for (size_t i = 0; i < res.size(); ++i)
+    res[i] = ids[res[i]];
+}
+
+/**
+ * Initializes a run from the shared dataset or, if the grid filter has 
+ * reduced it, from the remaining rows. The run takes its buffers from
+ * arena, which is reset first (so that the previous run must be deleted).
+ */
+void initRun( SkylineI* skyline, const SharedDataset &data, float** rows,
+    Arena &arena ) {
+  arena.Reset();
+  skyline->SetArena( &arena );
+  if ( rows == data.rows() )
+    skyline->InitShared( data );
+  else
+    skyline->Init( rows );
+}
+
+/**
+ * Prints how much of the arena the last run used, and how the arena was
+ * backed (see huge_pages.h).
+ */
+void printPages( const Arena &arena ) {
+  const PageKind kinds[] = { PAGES_HUGETLB, PAGES_TRANSPARENT, PAGES_SMALL,
+      PAGES_HEAP };
+  printf( " per-run buffers: %.1f MB, in arena chunks of:\n",
+      arena.used() / (1024.0 * 1024.0) );
+  for (uint32_t k = 0; k < 4; ++k) {
+    if ( arena.capacity( kinds[k] ) > 0 )
+      printf( "  %.1f MB on %s pages\n",
+          arena.capacity( kinds[k] ) / (1024.0 * 1024.0),
+          PageKindName( kinds[k] ) );
+  }
+  printf( " arena chunks backed by huge pages: %.1f MB\n",
+      arena.huge_bytes() / (1024.0 * 1024.0) );
+}
+
 /**
  * Create multi-threaded skyline algorithm
  */
-SkylineI* createMTSkyline( string alg_name, const uint32_t n, const uint32_t d,
-    float** data, uint32_t threads, uint32_t alpha, uint32_t pq_size ) {
+SkylineI* createMTSkyline( string alg_name, const TupleIdx n, const uint32_t d,
+    float** data, uint32_t threads, uint32_t alpha, uint32_t pq_size,
+    bool numa, int pivot, float sample_ratio, bool rank ) {
   if ( alg_name.compare( ALG_PSKYLINE ) == 0 )
-    return new PSkyline( threads, n, d, data );
+    return new PSkyline( threads, n, d, data, sample_ratio );
   if ( alg_name.compare( ALG_QFLOW ) == 0 )
-    return new QFlow( threads, n, d, data, alpha );
+    return new QFlow( threads, n, d, data, alpha, sample_ratio, rank );
   if ( alg_name.compare( ALG_HYBRID ) == 0 )
-    return new Hybrid( threads, n, d, alpha, pq_size );
+    return new Hybrid( threads, n, d, alpha, pq_size,
+        pivotOr( pivot, PIVOT_MEDIAN ), DEFAULT_SPLIT_SIZE, DEFAULT_MAX_DEPTH,
+        numa, sample_ratio );
   if ( alg_name.compare( ALG_PBSKYTREE ) == 0 )
-    return new ParallelBSkyTree( threads, n, d, data );
+    return new ParallelBSkyTree( threads, n, d, data,
+        pivotOr( pivot, PIVOT_BALSKY ) );
+  if ( alg_name.compare( ALG_TBSKYTREE ) == 0 )
+    return new SkyTree( n, d, data, true, false, threads,
+        pivotOr( pivot, PIVOT_BALSKY ) );
 
   return NULL;
 }
@@ -77,10 +186,11 @@ SkylineI* createMTSkyline( string alg_name, const uint32_t n, const uint32_t d,
 /**
  * Creates single-threaded skyline algorithm
  */
-SkylineI* createSkyline( string alg_name, const uint32_t n, const uint32_t d,
-    float** data ) {
+SkylineI* createSkyline( string alg_name, const TupleIdx n, const uint32_t d,
+    float** data, int pivot ) {
   if ( alg_name.compare( ALG_BSKYTREE ) == 0 )
-    return new SkyTree( n, d, data, true, false );
+    return new SkyTree( n, d, data, true, false, 0,
+        pivotOr( pivot, PIVOT_BALSKY ) );
 
   return NULL;
 }
@@ -88,20 +198,26 @@ SkylineI* createSkyline( string alg_name, const uint32_t n, const uint32_t d,
 void doPerformanceTest( Config &cfg ) {
   vector<vector<float> > vvf = read_data( cfg.input_fname.c_str(), false,
       false );
-  const uint32_t n = vvf.size();
+  const TupleIdx n = vvf.size();
   const uint32_t d = vvf.front().size();
 #if COUNT_DT==1
   extern uint64_t dt_count;
   extern uint64_t dt_count_dom;
   extern uint64_t dt_count_incomp;
+  extern uint64_t dt_count_skip;
 #endif
 
-  float** data = AllocateDoubleArray( n, d );
-  redistribute_data( vvf, data );
+  /* Lay out the input once; all runs share it (read-only). */
+  const SharedDataset data( vvf, cfg.max_threads, cfg.huge );
   vvf.clear();
+  Arena arena( cfg.huge ); // per-run buffers, reused across runs
+
+  TupleIdx m;
+  vector<TupleIdx> ids;
+  float** rows = reduceInput( cfg, data.rows(), n, m, ids );
 
   long msec = 0;
-  vector<vector<int> > results;
+  vector<vector<TupleId> > results;
 
   for (uint32_t a = 0; a < cfg.algo.size(); ++a) {
     if ( isMC( cfg.algo[a] ) ) { // Multi-threaded algorithm run
@@ -110,17 +226,19 @@ void doPerformanceTest( Config &cfg ) {
         dt_count = 0;
         dt_count_dom = 0;
         dt_count_incomp = 0;
+        dt_count_skip = 0;
 #endif
         const uint32_t num_threads = atoi( cfg.threads[t].c_str() );
-        SkylineI* skyline = createMTSkyline( cfg.algo[a], n, d, data,
-            num_threads, cfg.alpha_size, cfg.pq_size );
+        SkylineI* skyline = createMTSkyline( cfg.algo[a], m, d, rows,
+            num_threads, cfg.alpha_size, cfg.pq_size, cfg.numa,
+            cfg.pivot, cfg.sample_ratio, cfg.rank );
         if ( skyline != NULL ) {
           msec = GetTime();
           // initialization:
-          skyline->Init( data );
+          initRun( skyline, data, rows, arena );
 
           // skyline computation:
-          vector<int> res = skyline->Execute();
+          vector<TupleId> res = skyline->Execute();
 
 #if COUNT_DT==1
           printf( " %lu", dt_count / n );
@@ -129,6 +247,7 @@ void doPerformanceTest( Config &cfg ) {
 #else
           printf( " %ld", GetTime() - msec );
 #endif
+          mapToInput( res, ids );
           results.push_back( res );
           delete skyline;
         } else {
@@ -137,17 +256,18 @@ void doPerformanceTest( Config &cfg ) {
         }
       }
     } else { // Single-threaded algorithm run
-      SkylineI* skyline = createSkyline( cfg.algo[a], n, d, data );
+      SkylineI* skyline = createSkyline( cfg.algo[a], m, d, rows, cfg.pivot );
       if ( skyline != NULL ) {
 #if COUNT_DT==1
         dt_count = 0;
         dt_count_dom = 0;
         dt_count_incomp = 0;
+        dt_count_skip = 0;
 #endif
         msec = GetTime();
-        skyline->Init( data );
+        initRun( skyline, data, rows, arena );
 
-        vector<int> res = skyline->Execute();
+        vector<TupleId> res = skyline->Execute();
 #if COUNT_DT==1
         printf( " %lu", dt_count / n );
 //        printf( " %lu", dt_count_dom / n );
@@ -155,6 +275,7 @@ void doPerformanceTest( Config &cfg ) {
 #else
         printf( " %ld", GetTime() - msec );
 #endif
+        mapToInput( res, ids );
         results.push_back( res );
         delete skyline;
       } else {
@@ -171,6 +292,9 @@ void doPerformanceTest( Config &cfg ) {
         fprintf( stderr, "ERROR: Skylines of run #%u (|sky|=%lu) "
             "and #%u (|sky|=%lu) do not match!!!\n", 0, results[0].size(), i,
             results[i].size() );
+
+  if ( rows != data.rows() )
+    delete[] rows;
 }
 
 void doVerboseTest( Config &cfg ) {
@@ -178,27 +302,45 @@ void doVerboseTest( Config &cfg ) {
   extern uint64_t dt_count;
   extern uint64_t dt_count_dom;
   extern uint64_t dt_count_incomp;
+  extern uint64_t dt_count_skip;
 #endif
   long msec = 0;
-  vector<vector<int> > results;
+  vector<vector<TupleId> > results;
 
   printf( "Input reading (%s)\n", cfg.input_fname.c_str() );
   msec = GetTime();
   vector<vector<float> > vvf = read_data( cfg.input_fname.c_str(), false,
       false );
-  const uint32_t n = vvf.size();
+  const TupleIdx n = vvf.size();
   const uint32_t d = vvf.front().size();
   msec = GetTime() - msec;
-  printf( " d=%d;\n n=%d\n", d, n );
+  printf( " d=%d;\n n=%llu\n", d, (unsigned long long) n );
   printf( " duration: %ld msec\n", msec );
   if (n < cfg.alpha_size)
     cfg.alpha_size = n / 2;
   if (n < cfg.pq_size)
     cfg.pq_size = 1;
 
-  float** data = AllocateDoubleArray( n, d );
-  redistribute_data( vvf, data );
+  /* Lay out the input once; all runs share it (read-only). */
+  const SharedDataset data( vvf, cfg.max_threads, cfg.huge );
   vvf.clear();
+  Arena arena( cfg.huge ); // per-run buffers, reused across runs
+
+  if ( cfg.huge ) {
+    printf( " input on %s pages (%.1f MB backed by huge pages)\n",
+        PageKindName( data.pages() ), data.huge_bytes() / (1024.0 * 1024.0) );
+  }
+
+  TupleIdx m;
+  vector<TupleIdx> ids;
+  msec = GetTime();
+  float** rows = reduceInput( cfg, data.rows(), n, m, ids );
+  if ( cfg.grid ) {
+    printf( "Grid filter\n" );
+    printf( " kept %llu of %llu tuples (%.2f %%)\n", (unsigned long long) m,
+        (unsigned long long) n, m * 100.0 / n );
+    printf( " duration: %ld msec\n", GetTime() - msec );
+  }
 
   for (uint32_t a = 0; a < cfg.algo.size(); ++a) {
     if ( isMC( cfg.algo[a] ) ) { // Multi-threaded algorithm run
@@ -207,30 +349,36 @@ void doVerboseTest( Config &cfg ) {
         dt_count = 0;
         dt_count_dom = 0;
         dt_count_incomp = 0;
+        dt_count_skip = 0;
 #endif
         const uint32_t num_threads = atoi( cfg.threads[t].c_str() );
-        SkylineI* skyline = createMTSkyline( cfg.algo[a], n, d, data,
-            num_threads, cfg.alpha_size, cfg.pq_size );
+        SkylineI* skyline = createMTSkyline( cfg.algo[a], m, d, rows,
+            num_threads, cfg.alpha_size, cfg.pq_size, cfg.numa,
+            cfg.pivot, cfg.sample_ratio, cfg.rank );
         if ( skyline != NULL ) {
           printf( "#%u: %s (t=%u)\n", a, cfg.algo[a].c_str(), num_threads );
           msec = GetTime();
           // initialization:
-          skyline->Init( data );
+          initRun( skyline, data, rows, arena );
           long elapsed_msec = GetTime() - msec;
           printf( " init: %ld msec \n", elapsed_msec );
 
           // skyline computation:
-          vector<int> res = skyline->Execute();
+          vector<TupleId> res = skyline->Execute();
           elapsed_msec = GetTime() - msec;
 
           printf( " runtime: %ld msec ", elapsed_msec );
           PrintTime( elapsed_msec );
+          mapToInput( res, ids );
           results.push_back( res );
           delete skyline;
+          if ( cfg.huge )
+            printPages( arena );
 #if COUNT_DT==1
           printf( " DT/pt: %.2f\n", dt_count / (float) n );
           printf( " DT-dom/pt: %.2f\n", dt_count_dom / (float) n );
           printf( " DT-incomp/pt: %.2f\n", dt_count_incomp / (float) n );
+          printf( " DT-saved/pt: %.2f\n", dt_count_skip / (float) n );
 #endif
         } else {
           printf( "Warning: unknown multi-threaded algorithm '%s' is skipped\n",
@@ -242,28 +390,33 @@ void doVerboseTest( Config &cfg ) {
       dt_count = 0;
       dt_count_dom = 0;
       dt_count_incomp = 0;
+      dt_count_skip = 0;
 #endif
-      SkylineI* skyline = createSkyline( cfg.algo[a], n, d, data );
+      SkylineI* skyline = createSkyline( cfg.algo[a], m, d, rows, cfg.pivot );
       if ( skyline != NULL ) {
         printf( "#%u: %s\n", a, cfg.algo[a].c_str() );
         msec = GetTime();
         // initialization:
-        skyline->Init( data );
+        initRun( skyline, data, rows, arena );
         long elapsed_msec = GetTime() - msec;
         printf( " init: %ld msec \n", elapsed_msec );
 
         // skyline computation:
-        vector<int> res = skyline->Execute();
+        vector<TupleId> res = skyline->Execute();
         elapsed_msec = GetTime() - msec;
 
         printf( " runtime: %ld msec ", elapsed_msec );
         PrintTime( elapsed_msec );
+        mapToInput( res, ids );
         results.push_back( res );
         delete skyline;
+        if ( cfg.huge )
+          printPages( arena );
 #if COUNT_DT==1
         printf( " DT/pt: %.2f\n", dt_count / (float) n );
         printf( " DT-dom/pt: %.2f\n", dt_count_dom / (float) n );
         printf( " DT-incomp/pt: %.2f\n", dt_count_incomp / (float) n );
+        printf( " DT-saved/pt: %.2f\n", dt_count_skip / (float) n );
 #endif
       } else {
         printf( "Warning: unknown single-threaded algorithm '%s' is skipped\n",
@@ -292,13 +445,15 @@ void doVerboseTest( Config &cfg ) {
     printf( " |skyline| = %lu (%.2f %%)\n", results[0].size(),
         results[0].size() * 100.0 / n );
 
-  FreeDoubleArray( n, data );
+  if ( rows != data.rows() )
+    delete[] rows;
 }
 
 void printUsage() {
   printf( "\nSkyBench - a benchmark for skyline algorithms \n\n" );
   printf( "USAGE: ./SkyBench -f filename [-s \"alg names\"] [-t \"num_threads\"] [-v]\n" );
-  printf( "       [-a size] [-q size]\n" );
+  printf( "       [-a size] [-q size] [-n] [-b policy] [-p policy] [-r ratio] [-g] [-k]\n" );
+  printf( "       [-l]\n" );
   printf( " -f: input filename\n" );
   printf( " -t: run with num_threads, e.g., \"1 2 4\" (default \"4\")\n" );
   printf( "     Note: used only with multi-threaded algorithms\n" );
@@ -306,6 +461,18 @@ void printUsage() {
   printf( "     Supported algorithms: [\"%s\"]\n", ALG_ALL );
   printf( " -a: alpha block size (default 1024)\n" );
   printf( " -q: priority queue size (only hybrid)\n" );
+  printf( " -n: NUMA mode, replicating the skyline per socket (only hybrid)\n" );
+  printf( " -b: thread affinity policy: none (default), compact, scatter,\n" );
+  printf( "     or physical (one thread per physical core)\n" );
+  printf( " -p: pivot policy: random, median, balanced, balsky, manhattan,\n" );
+  printf( "     or volume (default median for hybrid, balsky for the BSkyTrees)\n" );
+  printf( " -r: pre-filter with the skyline of a random sample of this ratio\n" );
+  printf( "     of the input, e.g., 0.01 (default 0 = off; hybrid, qflow, pskyline)\n" );
+  printf( " -g: grid filter: first eliminate the tuples in grid cells that are\n" );
+  printf( "     dominated by an occupied cell (timed only in verbose mode)\n" );
+  printf( " -k: run on 8/16-bit dense ranks of the values, if they fit (only qflow)\n" );
+  printf( " -l: allocate the input and the tuple arrays on 2 MB pages, where\n" );
+  printf( "     available (the pages obtained are reported with -v)\n" );
   printf( " -v: verbose mode (don't use for performance experiments!)\n\n" );
   printf( "Example: " );
   printf( "./SkyBench -f workloads/house-U-6-127931.csv -s \"bskytree hybrid\"\n\n" );
@@ -319,12 +486,20 @@ int main( int argc, char** argv ) {
   cfg.input_fname = "";
   cfg.alpha_size = DEFAULT_ALPHA;
   cfg.pq_size = DEFAULT_QP_SIZE;
+  cfg.numa = false;
+  cfg.affinity = AFFINITY_NONE;
+  cfg.pivot = -1;
+  cfg.sample_ratio = 0;
+  cfg.grid = false;
+  cfg.rank = false;
+  cfg.huge = false;
+  uint32_t pivot;
   int index;
   int c;
 
   opterr = 0;
 
-  while ( (c = getopt( argc, argv, "f:t:s:a:q:vm:" )) != -1 ) {
+  while ( (c = getopt( argc, argv, "f:t:s:a:q:vm:nb:p:r:gkl" )) != -1 ) {
     switch ( c ) {
     case 'f':
       cfg.input_fname = string( optarg );
@@ -344,6 +519,36 @@ int main( int argc, char** argv ) {
     case 'q':
       cfg.pq_size = atoi( optarg );
       break;
+    case 'n':
+      cfg.numa = true;
+      break;
+    case 'b':
+      if ( !ParseAffinityPolicy( optarg, &cfg.affinity ) ) {
+        fprintf( stderr, "Unknown affinity policy `%s'.\n", optarg );
+        printUsage();
+        return 1;
+      }
+      break;
+    case 'p':
+      if ( !ParsePivotPolicy( optarg, &pivot ) ) {
+        fprintf( stderr, "Unknown pivot policy `%s'.\n", optarg );
+        printUsage();
+        return 1;
+      }
+      cfg.pivot = pivot;
+      break;
+    case 'r':
+      cfg.sample_ratio = atof( optarg );
+      break;
+    case 'g':
+      cfg.grid = true;
+      break;
+    case 'k':
+      cfg.rank = true;
+      break;
+    case 'l':
+      cfg.huge = true;
+      break;
     default:
       if ( isprint( optopt ) )
         fprintf( stderr, "Unknown option `-%c'.\n", optopt );
@@ -360,6 +565,23 @@ int main( int argc, char** argv ) {
   cfg.threads = my_split( num_threads, ' ' );
   cfg.algo = my_split( algorithms, ' ' );
 
+  /* Start (and place) the thread pool once, for the largest thread count,
+   * so that all algorithms and thread counts reuse the same threads. */
+  uint32_t max_threads = 1;
+  for (uint32_t t = 0; t < cfg.threads.size(); ++t) {
+    const uint32_t num = atoi( cfg.threads[t].c_str() );
+    if ( num > max_threads )
+      max_threads = num;
+  }
+  cfg.max_threads = max_threads;
+  const vector<uint32_t> cpu_map = PinThreadPool( cfg.affinity, max_threads );
+  if ( verbose ) {
+    printf( "CPU map (%s):", AffinityPolicyName( cfg.affinity ) );
+    for (uint32_t t = 0; t < cpu_map.size(); ++t)
+      printf( " %u->%u", t, cpu_map[t] );
+    printf( "\n" );
+  }
+
   if ( verbose ) {
     printf( "Running in verbose (-v) mode\n" );
     doVerboseTest( cfg );
@@ -0,0 +1,159 @@
+/*
+ * affinity.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "util/affinity.h"
+
+#include <sched.h>
+#include <cstring>
+#include <algorithm>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#define omp_set_dynamic( b ) 0
+#endif
+
+#include "util/topology.h"
+
+/*
+ * Orders CPUs first by a per-policy rank, then by CPU id.
+ */
+typedef struct RankedCpu {
+  uint32_t rank[3];
+  uint32_t cpu;
+  bool operator<( const RankedCpu &rhs ) const {
+    for (uint32_t i = 0; i < 3; ++i) {
+      if ( rank[i] != rhs.rank[i] )
+        return rank[i] < rhs.rank[i];
+    }
+    return cpu < rhs.cpu;
+  }
+} RankedCpu;
+
+bool ParseAffinityPolicy( const char *name, AffinityPolicy *policy ) {
+  if ( strcmp( name, "none" ) == 0 )
+    *policy = AFFINITY_NONE;
+  else if ( strcmp( name, "compact" ) == 0 )
+    *policy = AFFINITY_COMPACT;
+  else if ( strcmp( name, "scatter" ) == 0 )
+    *policy = AFFINITY_SCATTER;
+  else if ( strcmp( name, "physical" ) == 0 )
+    *policy = AFFINITY_PHYSICAL;
+  else
+    return false;
+  return true;
+}
+
+const char* AffinityPolicyName( const AffinityPolicy policy ) {
+  switch ( policy ) {
+  case AFFINITY_COMPACT:
+    return "compact";
+  case AFFINITY_SCATTER:
+    return "scatter";
+  case AFFINITY_PHYSICAL:
+    return "physical";
+  default:
+    return "none";
+  }
+}
+
+/*
+ * Returns the CPUs on which this process may run, as they were at the
+ * first call (i.e., before any thread was pinned).
+ */
+static const std::vector<uint32_t>& AllowedCpus() {
+  static std::vector<uint32_t> allowed;
+  if ( allowed.empty() ) {
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    const uint32_t num_cpus = GetNumCpus();
+    if ( sched_getaffinity( 0, sizeof(set), &set ) == 0 ) {
+      for (uint32_t cpu = 0; cpu < num_cpus && cpu < CPU_SETSIZE; ++cpu) {
+        if ( CPU_ISSET( cpu, &set ) )
+          allowed.push_back( cpu );
+      }
+    }
+    if ( allowed.empty() ) {
+      for (uint32_t cpu = 0; cpu < num_cpus; ++cpu)
+        allowed.push_back( cpu );
+    }
+  }
+  return allowed;
+}
+
+std::vector<uint32_t> GetCpuOrder( const AffinityPolicy policy ) {
+  const std::vector<uint32_t> &allowed = AllowedCpus();
+  if ( policy == AFFINITY_NONE )
+    return allowed;
+
+  /* Number the SMT siblings of each core, and the cores of each socket,
+   * in order of CPU id. */
+  std::vector<uint32_t> smt_index( allowed.size() ),
+      core_index( allowed.size() );
+  std::vector<uint32_t> siblings_seen( GetNumCores(), 0 );
+  std::vector<uint32_t> cores_seen( GetNumSockets(), 0 );
+  std::vector<bool> core_numbered( GetNumCores(), false );
+  std::vector<uint32_t> core_rank( GetNumCores(), 0 );
+  for (uint32_t i = 0; i < allowed.size(); ++i) {
+    const uint32_t core = GetCoreOfCpu( allowed[i] );
+    const uint32_t socket = GetSocketOfCpu( allowed[i] );
+    if ( !core_numbered[core] ) {
+      core_numbered[core] = true;
+      core_rank[core] = cores_seen[socket]++;
+    }
+    smt_index[i] = siblings_seen[core]++;
+    core_index[i] = core_rank[core];
+  }
+
+  std::vector<RankedCpu> ranked;
+  for (uint32_t i = 0; i < allowed.size(); ++i) {
+    if ( policy == AFFINITY_PHYSICAL && smt_index[i] > 0 )
+      continue;
+    RankedCpu r;
+    r.cpu = allowed[i];
+    const uint32_t socket = GetSocketOfCpu( allowed[i] );
+    if ( policy == AFFINITY_SCATTER ) {
+      r.rank[0] = smt_index[i];
+      r.rank[1] = core_index[i];
+      r.rank[2] = socket;
+    } else {
+      r.rank[0] = socket;
+      r.rank[1] = core_index[i];
+      r.rank[2] = smt_index[i];
+    }
+    ranked.push_back( r );
+  }
+  std::sort( ranked.begin(), ranked.end() );
+
+  std::vector<uint32_t> order;
+  for (uint32_t i = 0; i < ranked.size(); ++i)
+    order.push_back( ranked[i].cpu );
+  return order;
+}
+
+std::vector<uint32_t> PinThreadPool( const AffinityPolicy policy,
+    const uint32_t num_threads ) {
+  const std::vector<uint32_t> order = GetCpuOrder( policy );
+  std::vector<uint32_t> placed( num_threads, 0 );
+
+  /* Keep team sizes exact, so that later regions reuse the pinned threads. */
+  omp_set_dynamic( 0 );
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    const uint32_t th = omp_get_thread_num();
+    if ( policy != AFFINITY_NONE ) {
+      cpu_set_t set;
+      CPU_ZERO( &set );
+      CPU_SET( order[th % order.size()], &set );
+      sched_setaffinity( 0, sizeof(set), &set );
+    }
+    const int cpu = sched_getcpu();
+    placed[th] = cpu < 0 ? 0 : cpu;
+  } // END PARALLEL
+  return placed;
+}
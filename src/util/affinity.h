@@ -0,0 +1,50 @@
+/*
+ * affinity.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Placement of the OpenMP worker threads onto logical CPUs. The OpenMP
+ *  runtime keeps its threads alive between parallel regions, so pinning
+ *  them once (for the largest thread count that will be used) fixes the
+ *  placement for every algorithm and thread count run afterwards.
+ */
+
+#ifndef AFFINITY_H_
+#define AFFINITY_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+enum AffinityPolicy {
+  AFFINITY_NONE, // leave placement to the OS/OpenMP runtime
+  AFFINITY_COMPACT, // fill all hardware threads of a socket, then the next
+  AFFINITY_SCATTER, // spread over sockets, then physical cores, then SMT
+  AFFINITY_PHYSICAL // one hardware thread per physical core, compactly
+};
+
+/*
+ * Parses a policy name ("none", "compact", "scatter" or "physical").
+ * Returns false if the name is unknown.
+ */
+bool ParseAffinityPolicy( const char *name, AffinityPolicy *policy );
+
+const char* AffinityPolicyName( const AffinityPolicy policy );
+
+/*
+ * Returns the logical CPUs to which threads 0, 1, ... are pinned under
+ * policy, restricted to the CPUs on which this process may run.
+ */
+std::vector<uint32_t> GetCpuOrder( const AffinityPolicy policy );
+
+/*
+ * Creates the OpenMP thread pool with num_threads threads and pins 
+ * thread i to GetCpuOrder( policy )[i] (wrapping around if there are more
+ * threads than CPUs). Returns the CPU on which each thread runs afterwards.
+ * Must be called outside of any parallel region, before the threads
+ * are used by the algorithms.
+ */
+std::vector<uint32_t> PinThreadPool( const AffinityPolicy policy,
+    const uint32_t num_threads );
+
+#endif /* AFFINITY_H_ */
@@ -0,0 +1,110 @@
+/*
+ * topology.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "util/topology.h"
+
+#include <sched.h>
+#include <unistd.h>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+typedef struct CpuInfo {
+  uint32_t socket; // dense socket id
+  uint32_t core; // dense physical core id (unique across sockets)
+} CpuInfo;
+
+/*
+ * Reads one integer from a sysfs file, or returns def if unavailable.
+ */
+static int ReadSysInt( const char *fmt, const long cpu, const int def ) {
+  char path[128];
+  int value = def;
+  snprintf( path, sizeof(path), fmt, cpu );
+  FILE *f = fopen( path, "r" );
+  if ( f != NULL ) {
+    if ( fscanf( f, "%d", &value ) != 1 )
+      value = def;
+    fclose( f );
+  }
+  return value;
+}
+
+/*
+ * Reads the socket and physical core of every logical CPU once. If the
+ * topology is not exposed, every CPU is assumed to be its own core on
+ * one socket.
+ */
+static const std::vector<CpuInfo>& CpuMap( uint32_t *num_sockets,
+    uint32_t *num_cores ) {
+  static std::vector<CpuInfo> cpus;
+  static uint32_t sockets = 0, cores = 0;
+  if ( cpus.empty() ) {
+    long num_cpus = sysconf( _SC_NPROCESSORS_CONF );
+    if ( num_cpus < 1 )
+      num_cpus = 1;
+    std::map<int, uint32_t> dense_socket;
+    std::map<std::pair<int, int>, uint32_t> dense_core;
+    for (long cpu = 0; cpu < num_cpus; ++cpu) {
+      const int package = ReadSysInt(
+          "/sys/devices/system/cpu/cpu%ld/topology/physical_package_id", cpu,
+          0 );
+      const int core = ReadSysInt(
+          "/sys/devices/system/cpu/cpu%ld/topology/core_id", cpu, cpu );
+      if ( dense_socket.find( package ) == dense_socket.end() ) {
+        const uint32_t id = dense_socket.size();
+        dense_socket[package] = id;
+      }
+      const std::pair<int, int> key( package, core );
+      if ( dense_core.find( key ) == dense_core.end() ) {
+        const uint32_t id = dense_core.size();
+        dense_core[key] = id;
+      }
+      CpuInfo info;
+      info.socket = dense_socket[package];
+      info.core = dense_core[key];
+      cpus.push_back( info );
+    }
+    sockets = dense_socket.size();
+    cores = dense_core.size();
+  }
+  if ( num_sockets != NULL )
+    *num_sockets = sockets;
+  if ( num_cores != NULL )
+    *num_cores = cores;
+  return cpus;
+}
+
+uint32_t GetNumSockets() {
+  uint32_t sockets;
+  CpuMap( &sockets, NULL );
+  return sockets;
+}
+
+uint32_t GetNumCores() {
+  uint32_t cores;
+  CpuMap( NULL, &cores );
+  return cores;
+}
+
+uint32_t GetNumCpus() {
+  return CpuMap( NULL, NULL ).size();
+}
+
+uint32_t GetSocketOfCpu( const uint32_t cpu ) {
+  const std::vector<CpuInfo> &cpus = CpuMap( NULL, NULL );
+  return cpu < cpus.size() ? cpus[cpu].socket : 0;
+}
+
+uint32_t GetCoreOfCpu( const uint32_t cpu ) {
+  const std::vector<CpuInfo> &cpus = CpuMap( NULL, NULL );
+  return cpu < cpus.size() ? cpus[cpu].core : cpu;
+}
+
+uint32_t GetCurrentSocket() {
+  const int cpu = sched_getcpu();
+  return cpu < 0 ? 0 : GetSocketOfCpu( cpu );
+}
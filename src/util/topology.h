@@ -0,0 +1,50 @@
+/*
+ * topology.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Discovery of the processor topology (i.e., which logical CPUs share
+ *  a socket or a physical core), as exposed by Linux under 
+ *  /sys/devices/system/cpu. Sockets and physical cores are numbered 
+ *  densely from 0, in order of their lowest CPU. The
+ *  topology is read on the first call, which should therefore not be
+ *  made concurrently.
+ */
+
+#ifndef TOPOLOGY_H_
+#define TOPOLOGY_H_
+
+#include <stdint.h>
+
+/*
+ * Returns the number of sockets (NUMA nodes, for our purposes).
+ */
+uint32_t GetNumSockets();
+
+/*
+ * Returns the number of physical cores (over all sockets).
+ */
+uint32_t GetNumCores();
+
+/*
+ * Returns the number of logical CPUs.
+ */
+uint32_t GetNumCpus();
+
+/*
+ * Returns the socket of the given logical CPU (0 if unknown).
+ */
+uint32_t GetSocketOfCpu( const uint32_t cpu );
+
+/*
+ * Returns the physical core of the given logical CPU, which is shared
+ * by its SMT siblings.
+ */
+uint32_t GetCoreOfCpu( const uint32_t cpu );
+
+/*
+ * Returns the socket on which the calling thread is currently running.
+ */
+uint32_t GetCurrentSocket();
+
+#endif /* TOPOLOGY_H_ */
@@ -7,6 +7,9 @@
 #include <map>
 #include <sstream>
 #include <algorithm>
+
+#include "common/common.h"
+
 #define DOM_P -1
 #define DOM_Q 1
 #define DOM_INCOMPARABLE 0
@@ -26,20 +29,21 @@ void FreeDoubleArray(const unsigned row, float** matrix) {
   delete[] matrix;
 }
 
-void PrintSkyline(const vector<int> &sky) {
+void PrintSkyline(const vector<TupleId> &sky) {
 //  printf(" ids:");
-  for (uint32_t i = 0; i < sky.size(); ++i) {
-    printf( " %d", sky[i] );
+  for (size_t i = 0; i < sky.size(); ++i) {
+    printf( " %lld", (long long) sky[i] );
   }
   printf( "\n" );
 }
 
-bool CompareTwoLists(vector<int>& list1, vector<int>& list2, bool print_missing) {
+bool CompareTwoLists(vector<TupleId>& list1, vector<TupleId>& list2,
+    bool print_missing) {
   bool flag = true;
   if ( list1.size() == list2.size() ) {
     sort( list1.begin(), list1.end() );
     sort( list2.begin(), list2.end() );
-    for (unsigned i = 0; i < list1.size(); i++) {
+    for (size_t i = 0; i < list1.size(); i++) {
       if ( list1[i] != list2[i] ) {
         flag = false;
         break;
@@ -53,16 +57,16 @@ bool CompareTwoLists(vector<int>& list1, vector<int>& list2, bool print_missing)
     sort( list1.begin(), list1.end() );
     sort( list2.begin(), list2.end() );
     printf( "list1 missing:" );
-    for (uint32_t i = 0; i < list2.size(); ++i) {
+    for (size_t i = 0; i < list2.size(); ++i) {
       if ( !std::binary_search( list1.begin(), list1.end(), list2[i] ) ) {
-        printf( " %d", list2[i] );
+        printf( " %lld", (long long) list2[i] );
       }
     }
     printf( "\n" );
     printf( "list2 missing:" );
-    for (uint32_t i = 0; i < list1.size(); ++i) {
+    for (size_t i = 0; i < list1.size(); ++i) {
       if ( !std::binary_search( list2.begin(), list2.end(), list1[i] ) ) {
-        printf( " %d", list1[i] );
+        printf( " %lld", (long long) list1[i] );
       }
     }
     printf( "\n" );